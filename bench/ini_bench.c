@@ -0,0 +1,488 @@
+/** Benchmark of parser of .ini files
+*
+*	Copyright (c) 2021 Sw1ft
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "ini_parser.h"
+
+#define BENCH_DEFAULT_ITERATIONS 5
+#define BENCH_DEFAULT_LOOKUPS 1000000
+
+//-----------------------------------------------------------------------------
+// Allocations made by parser, counted when linked with
+// -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc (see Makefile)
+//-----------------------------------------------------------------------------
+
+static unsigned long long s_allocations = 0;
+static unsigned long long s_allocatedBytes = 0;
+
+#ifdef INI_BENCH_COUNT_ALLOCATIONS
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *memory, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+	++s_allocations;
+	s_allocatedBytes += size;
+
+	return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+	++s_allocations;
+	s_allocatedBytes += count * size;
+
+	return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *memory, size_t size)
+{
+	++s_allocations;
+	s_allocatedBytes += size;
+
+	return __real_realloc(memory, size);
+}
+#endif
+
+//-----------------------------------------------------------------------------
+// Results of one file
+//-----------------------------------------------------------------------------
+
+typedef struct
+{
+	const char *filename;
+	size_t size;
+
+	size_t entry_count;
+	size_t section_count;
+
+	// Best time of iterations in seconds
+	double parse_file;
+	double parse_buffer;
+	double parse_mmap;
+
+	double free_time;
+
+	// Per parse of buffer
+	unsigned long long allocations;
+	unsigned long long allocated_bytes;
+
+	double lookup_hit;
+	double lookup_miss;
+	double lookup_frozen;
+
+	// Index of entries
+	double load_factor;
+	double average_probe;
+	size_t max_probe;
+} bench_result_t;
+
+//-----------------------------------------------------------------------------
+// Parameter to look up, names are NUL-terminated copies
+//-----------------------------------------------------------------------------
+
+typedef struct
+{
+	char *section;
+	char *key;
+} bench_key_t;
+
+//-----------------------------------------------------------------------------
+// Purpose: monotonic time in seconds
+//-----------------------------------------------------------------------------
+
+static double bench_now()
+{
+#ifdef _WIN32
+	LARGE_INTEGER frequency, counter;
+
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+
+	return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+
+	return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: read whole file in memory
+//-----------------------------------------------------------------------------
+
+static char *bench_read_file(const char *filename, size_t *size)
+{
+	FILE *file = fopen(filename, "rb");
+
+	if (!file)
+		return NULL;
+
+	fseek(file, 0, SEEK_END);
+	long length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	char *buffer = (length >= 0) ? malloc((size_t)length + 1) : NULL;
+
+	if (buffer && fread(buffer, 1, (size_t)length, file) != (size_t)length)
+	{
+		free(buffer);
+		buffer = NULL;
+	}
+
+	fclose(file);
+
+	*size = (size_t)length;
+	return buffer;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: copy names of random entries, missing keys get suffix
+//-----------------------------------------------------------------------------
+
+static bench_key_t *bench_collect_keys(const struct ini_data *data, size_t count, int isMissing)
+{
+	bench_key_t *keys = calloc(count, sizeof(bench_key_t));
+
+	if (!keys)
+		return NULL;
+
+	unsigned long long random = 0x9E3779B97F4A7C15ULL;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		random ^= random << 13;
+		random ^= random >> 7;
+		random ^= random << 17;
+
+		const struct ini_entry *entry = &data->entries[random % data->entry_count];
+
+		keys[i].section = malloc(entry->section->length + 1);
+		keys[i].key = malloc(entry->key_length + 9);
+
+		if (!keys[i].section || !keys[i].key)
+			continue;
+
+		memcpy(keys[i].section, entry->section->name, entry->section->length);
+		keys[i].section[entry->section->length] = '\0';
+
+		memcpy(keys[i].key, entry->key, entry->key_length);
+		strcpy(keys[i].key + entry->key_length, isMissing ? "_missing" : "");
+	}
+
+	return keys;
+}
+
+static void bench_free_keys(bench_key_t *keys, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		free(keys[i].section);
+		free(keys[i].key);
+	}
+
+	free(keys);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: average time of one ini_read_data in seconds
+//-----------------------------------------------------------------------------
+
+static double bench_lookup(struct ini_data *data, const bench_key_t *keys, size_t count, size_t lookups, size_t *found)
+{
+	struct ini_datatype datatype;
+	INI_FIELDTYPE_STRING_VIEW(datatype);
+
+	*found = 0;
+
+	double start = bench_now();
+
+	for (size_t i = 0; i < lookups; ++i)
+	{
+		const bench_key_t *key = &keys[i % count];
+
+		if (key->section && key->key && ini_read_data(data, key->section, key->key, &datatype, -1))
+			++*found;
+	}
+
+	return (bench_now() - start) / (double)lookups;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: average time of one ini_frozen_read in seconds
+//-----------------------------------------------------------------------------
+
+static double bench_lookup_frozen(const struct ini_frozen *frozen, const bench_key_t *keys, size_t count, size_t lookups, size_t *found)
+{
+	struct ini_datatype datatype;
+	INI_FIELDTYPE_STRING_VIEW(datatype);
+
+	*found = 0;
+
+	double start = bench_now();
+
+	for (size_t i = 0; i < lookups; ++i)
+	{
+		const bench_key_t *key = &keys[i % count];
+
+		if (key->section && key->key && ini_frozen_read(frozen, key->section, key->key, &datatype, -1))
+			++*found;
+	}
+
+	return (bench_now() - start) / (double)lookups;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: run all measures on file
+//-----------------------------------------------------------------------------
+
+static int bench_file(const char *filename, int iterations, size_t lookups, bench_result_t *result)
+{
+	memset(result, 0, sizeof(bench_result_t));
+	result->filename = filename;
+
+	size_t size;
+	char *buffer = bench_read_file(filename, &size);
+
+	if (!buffer)
+	{
+		fprintf(stderr, "Failed to read '%s'\n", filename);
+		return 0;
+	}
+
+	result->size = size;
+
+	struct ini_data data;
+
+	for (int i = 0; i < iterations; ++i)
+	{
+		double start = bench_now();
+
+		if (!ini_parse_data(filename, &data))
+		{
+			fprintf(stderr, "%s: %s in line %d\n", filename, ini_get_last_error_msg(), ini_get_last_line());
+			free(buffer);
+			return 0;
+		}
+
+		double time = bench_now() - start;
+
+		if (i == 0 || time < result->parse_file)
+			result->parse_file = time;
+
+		ini_free_data(&data, 0);
+
+		start = bench_now();
+		ini_parse_mmap_data(filename, &data);
+		time = bench_now() - start;
+
+		if (i == 0 || time < result->parse_mmap)
+			result->parse_mmap = time;
+
+		ini_free_data(&data, 0);
+
+		unsigned long long allocations = s_allocations;
+		unsigned long long allocatedBytes = s_allocatedBytes;
+
+		start = bench_now();
+		ini_parse_buffer_data(buffer, size, &data);
+		time = bench_now() - start;
+
+		if (i == 0 || time < result->parse_buffer)
+			result->parse_buffer = time;
+
+		result->allocations = s_allocations - allocations;
+		result->allocated_bytes = s_allocatedBytes - allocatedBytes;
+
+		// The last table is kept for lookups
+		if (i + 1 == iterations)
+			break;
+
+		start = bench_now();
+		ini_free_data(&data, 0);
+		time = bench_now() - start;
+
+		if (i == 0 || time < result->free_time)
+			result->free_time = time;
+	}
+
+	result->entry_count = data.entry_count;
+	result->section_count = data.section_count;
+
+	struct ini_table_stats tableStats;
+	ini_get_table_stats(&data, &tableStats);
+
+	result->load_factor = tableStats.entries.load_factor;
+	result->average_probe = tableStats.entries.average_probe;
+	result->max_probe = tableStats.entries.max_probe;
+
+	if (data.entry_count && lookups)
+	{
+		// Working set of keys is larger than caches of small tables, but fits in memory
+		size_t count = (lookups < (1 << 16)) ? lookups : (1 << 16);
+		size_t found;
+
+		bench_key_t *keys = bench_collect_keys(&data, count, 0);
+
+		if (keys)
+		{
+			result->lookup_hit = bench_lookup(&data, keys, count, lookups, &found);
+
+			if (found != lookups)
+				fprintf(stderr, "%s: %zu of %zu lookups failed\n", filename, lookups - found, lookups);
+
+			struct ini_frozen frozen;
+
+			if (ini_freeze(&data, &frozen))
+			{
+				result->lookup_frozen = bench_lookup_frozen(&frozen, keys, count, lookups, &found);
+				ini_frozen_free(&frozen);
+			}
+
+			bench_free_keys(keys, count);
+		}
+
+		keys = bench_collect_keys(&data, count, 1);
+
+		if (keys)
+		{
+			result->lookup_miss = bench_lookup(&data, keys, count, lookups, &found);
+			bench_free_keys(keys, count);
+		}
+	}
+
+	double start = bench_now();
+	ini_free_data(&data, 0);
+	double time = bench_now() - start;
+
+	if (iterations == 1 || time < result->free_time)
+		result->free_time = time;
+
+	free(buffer);
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: print results as text or as one JSON object per line
+//-----------------------------------------------------------------------------
+
+static void bench_print(const bench_result_t *result, int isJson)
+{
+	const double megabytes = (double)result->size / (1024.0 * 1024.0);
+
+#ifdef INI_BENCH_COUNT_ALLOCATIONS
+	const long long allocations = (long long)result->allocations;
+	const long long allocatedBytes = (long long)result->allocated_bytes;
+#else
+	const long long allocations = -1;
+	const long long allocatedBytes = -1;
+#endif
+
+	if (isJson)
+	{
+		printf("{\"file\":\"%s\",\"bytes\":%zu,\"sections\":%zu,\"entries\":%zu,"
+			"\"parse_file_mbps\":%.2f,\"parse_buffer_mbps\":%.2f,\"parse_mmap_mbps\":%.2f,"
+			"\"allocations\":%lld,\"allocated_bytes\":%lld,"
+			"\"lookup_hit_ns\":%.2f,\"lookup_miss_ns\":%.2f,\"lookup_frozen_ns\":%.2f,\"free_ms\":%.3f,"
+			"\"load_factor\":%.3f,\"average_probe\":%.3f,\"max_probe\":%zu}\n",
+			result->filename, result->size, result->section_count, result->entry_count,
+			megabytes / result->parse_file, megabytes / result->parse_buffer, megabytes / result->parse_mmap,
+			allocations, allocatedBytes,
+			result->lookup_hit * 1e9, result->lookup_miss * 1e9, result->lookup_frozen * 1e9, result->free_time * 1e3,
+			result->load_factor, result->average_probe, result->max_probe);
+
+		return;
+	}
+
+	printf("%s: %.2f MB, %zu sections, %zu entries\n", result->filename, megabytes, result->section_count, result->entry_count);
+	printf("  parse file    %10.2f MB/s\n", megabytes / result->parse_file);
+	printf("  parse buffer  %10.2f MB/s\n", megabytes / result->parse_buffer);
+	printf("  parse mmap    %10.2f MB/s\n", megabytes / result->parse_mmap);
+
+	if (allocations >= 0)
+		printf("  allocations   %10lld (%lld bytes)\n", allocations, allocatedBytes);
+
+	printf("  lookup hit    %10.2f ns/op\n", result->lookup_hit * 1e9);
+	printf("  lookup miss   %10.2f ns/op\n", result->lookup_miss * 1e9);
+	printf("  lookup frozen %10.2f ns/op\n", result->lookup_frozen * 1e9);
+	printf("  free          %10.3f ms\n", result->free_time * 1e3);
+	printf("  index         %10.3f load, %.3f average probe, %zu max probe\n", result->load_factor, result->average_probe, result->max_probe);
+}
+
+int main(int argc, char **argv)
+{
+	int iterations = BENCH_DEFAULT_ITERATIONS;
+	size_t lookups = BENCH_DEFAULT_LOOKUPS;
+	int isJson = 0;
+	int files = 0;
+	int failed = 0;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "-n") && i + 1 < argc)
+		{
+			iterations = atoi(argv[++i]);
+
+			if (iterations < 1)
+				iterations = 1;
+		}
+		else if (!strcmp(argv[i], "-l") && i + 1 < argc)
+		{
+			lookups = (size_t)strtoull(argv[++i], NULL, 10);
+		}
+		else if (!strcmp(argv[i], "-j"))
+		{
+			isJson = 1;
+		}
+		else
+		{
+			bench_result_t result;
+
+			if (bench_file(argv[i], iterations, lookups, &result))
+				bench_print(&result, isJson);
+			else
+				failed = 1;
+
+			++files;
+		}
+	}
+
+	if (!files)
+	{
+		fprintf(stderr, "Usage: %s [-n iterations] [-l lookups] [-j] file.ini ...\n", argv[0]);
+		return 1;
+	}
+
+	return failed;
+}
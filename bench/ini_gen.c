@@ -0,0 +1,262 @@
+/** Generator of synthetic .ini files for benchmarks
+*
+*	Copyright (c) 2021 Sw1ft
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ini_parser.h"
+
+//-----------------------------------------------------------------------------
+// Shapes of generated files
+//-----------------------------------------------------------------------------
+
+typedef enum
+{
+	PROFILE_FEW_SECTIONS = 0,	// 8 sections with a lot of parameters
+	PROFILE_MANY_SECTIONS,		// Sections with 4 parameters
+	PROFILE_LONG_LINES,			// Values longer than INI_BUFFER_LENGTH
+	PROFILE_COMMENTS,			// Comments, blank lines and inline comments around parameters
+	PROFILE_COLLISIONS,			// Keys which defeat weak hashes and make comparisons long
+	PROFILE_NUMERIC,			// Integers, hex, reals and booleans
+
+	PROFILE_COUNT
+} profile_t;
+
+static const char *s_profiles[PROFILE_COUNT] =
+{
+	"few",
+	"many",
+	"long",
+	"comments",
+	"collide",
+	"numeric"
+};
+
+// Common prefix of colliding keys, longer than a word of hash
+#define COLLISION_PREFIX "application_settings_subsystem_configuration_parameter_"
+
+static unsigned long long s_random = 0x2545F4914F6CDD1DULL;
+
+//-----------------------------------------------------------------------------
+// Purpose: xorshift generator, files are the same for the same seed
+//-----------------------------------------------------------------------------
+
+static unsigned int gen_random()
+{
+	s_random ^= s_random << 13;
+	s_random ^= s_random >> 7;
+	s_random ^= s_random << 17;
+
+	return (unsigned int)(s_random >> 32);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: append random word of lowercase letters
+//-----------------------------------------------------------------------------
+
+static size_t gen_word(char *buffer, size_t length)
+{
+	for (size_t i = 0; i < length; ++i)
+		buffer[i] = 'a' + gen_random() % 26;
+
+	return length;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: write value of parameter
+//-----------------------------------------------------------------------------
+
+static size_t gen_value(char *buffer, profile_t profile)
+{
+	if (profile == PROFILE_NUMERIC)
+	{
+		switch (gen_random() % 5)
+		{
+		case 0:
+			return sprintf(buffer, "%d", (int)gen_random() - 0x7FFFFFFF / 2);
+
+		case 1:
+			return sprintf(buffer, "0x%X", gen_random());
+
+		case 2:
+			return sprintf(buffer, "%.6f", (double)gen_random() / 1000.0);
+
+		case 3:
+			return sprintf(buffer, "%u.%ue-%u", gen_random() % 10, gen_random() % 100000, gen_random() % 30);
+
+		default:
+			return sprintf(buffer, "%s", (gen_random() & 1) ? "true" : "off");
+		}
+	}
+
+	size_t length;
+
+	if (profile == PROFILE_LONG_LINES)
+		length = INI_BUFFER_LENGTH + gen_random() % (INI_BUFFER_LENGTH * 15);
+	else
+		length = 4 + gen_random() % 28;
+
+	gen_word(buffer, length);
+
+	// Spaces inside of value
+	for (size_t i = 8; i + 1 < length; i += 9)
+		buffer[i] = ' ';
+
+	return length;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: write key sharing long prefix with the others, pairs of keys
+// differ only in order of the last two bytes, every section has the same keys
+//-----------------------------------------------------------------------------
+
+static size_t gen_colliding_key(char *buffer, size_t index)
+{
+	// Anagrams have the same sum and xor of bytes
+	return sprintf(buffer, COLLISION_PREFIX "%06zu_%s", index / 2, (index & 1) ? "ab" : "ba");
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: generate file of the given size
+//-----------------------------------------------------------------------------
+
+static int gen_file(FILE *file, profile_t profile, unsigned long long size)
+{
+	char *line = malloc(INI_BUFFER_LENGTH * 32);
+
+	if (!line)
+		return 0;
+
+	size_t keysPerSection = (profile == PROFILE_MANY_SECTIONS) ? 4 : (profile == PROFILE_LONG_LINES) ? 64 : 4096;
+	size_t sectionCount = 0;
+
+	unsigned long long written = 0;
+
+	while (written < size)
+	{
+		char section[64];
+
+		if (profile == PROFILE_FEW_SECTIONS)
+			sprintf(section, "section_%zu", sectionCount % 8);
+		else
+			sprintf(section, "section_%zu", sectionCount);
+
+		++sectionCount;
+
+		written += fprintf(file, "%s[%s]\n", (written ? "\n" : ""), section);
+
+		for (size_t i = 0; i < keysPerSection && written < size; ++i)
+		{
+			size_t length = 0;
+
+			if (profile == PROFILE_COMMENTS)
+			{
+				length += sprintf(line, "; Parameter %zu of %s\n# ", i, section);
+				length += gen_word(line + length, 40);
+				length += sprintf(line + length, "\n\n");
+			}
+
+			if (profile == PROFILE_COLLISIONS)
+			{
+				length += gen_colliding_key(line + length, i);
+			}
+			else if (profile == PROFILE_NUMERIC || profile == PROFILE_COMMENTS)
+			{
+				length += sprintf(line + length, "Parameter_%zu", i);
+			}
+			else
+			{
+				length += sprintf(line + length, "%s_", (i & 1) ? "Key" : "Setting");
+				length += gen_word(line + length, 6 + gen_random() % 10);
+				length += sprintf(line + length, "_%zu", i);
+			}
+
+			length += sprintf(line + length, (profile == PROFILE_COMMENTS) ? "  =  " : " = ");
+			length += gen_value(line + length, profile);
+
+			if (profile == PROFILE_COMMENTS)
+				length += sprintf(line + length, " ; inline comment");
+
+			line[length++] = '\n';
+
+			if (fwrite(line, 1, length, file) != length)
+			{
+				free(line);
+				return 0;
+			}
+
+			written += length;
+		}
+	}
+
+	free(line);
+
+	return 1;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 4)
+	{
+		fprintf(stderr, "Usage: %s <few|many|long|comments|collide|numeric> <megabytes> <output> [seed]\n", argv[0]);
+		return 1;
+	}
+
+	int profile = 0;
+
+	while (profile < PROFILE_COUNT && strcmp(argv[1], s_profiles[profile]))
+		++profile;
+
+	if (profile == PROFILE_COUNT)
+	{
+		fprintf(stderr, "Unknown profile '%s'\n", argv[1]);
+		return 1;
+	}
+
+	unsigned long long size = strtoull(argv[2], NULL, 10) << 20;
+
+	if (argc > 4)
+		s_random = (strtoull(argv[4], NULL, 10) * 0x9E3779B97F4A7C15ULL) | 1;
+
+	FILE *file = fopen(argv[3], "wb");
+
+	if (!file)
+	{
+		fprintf(stderr, "Failed to open '%s'\n", argv[3]);
+		return 1;
+	}
+
+	static char buffer[1 << 16];
+	setvbuf(file, buffer, _IOFBF, sizeof(buffer));
+
+	int success = gen_file(file, (profile_t)profile, size);
+
+	if (fclose(file) != 0 || !success)
+	{
+		fprintf(stderr, "Failed to write '%s'\n", argv[3]);
+		return 1;
+	}
+
+	return 0;
+}
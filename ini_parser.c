@@ -31,6 +31,11 @@
 #define _CRT_NONSTDC_NO_DEPRECATE
 #endif
 
+// POSIX functions of files (lstat, readlink, fdopen) are hidden by strict ISO C modes of glibc
+#if !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE
+#endif
+
 //-----------------------------------------------------------------------------
 
 #include "ini_parser.h"
@@ -38,478 +43,7003 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <float.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+#endif
 
 //-----------------------------------------------------------------------------
 
-#define INI_STRIP_CHARS (" \t\n")
+#define INI_STRIP_CHARS (" \t\r\n")
 
 #define INI_STRIP_CHARS_LEN (sizeof(INI_STRIP_CHARS) - 1)
 #define INI_COMMENT_PREFIX_LEN (sizeof(INI_COMMENT_PREFIX) - 1)
+#define INI_PARAMETER_DELIMITER_CHAR (INI_PARAMETER_DELIMITER[0])
+
+// Alignment of chunks of arena and entries inside them
+#define INI_ARENA_ALIGNMENT (sizeof(void *) > sizeof(long long) ? sizeof(void *) : sizeof(long long))
+
+// Size of block of line scanner
+#if defined(__AVX2__)
+#define INI_SCAN_WIDTH 32
+#define INI_SCAN_FULL_MASK 0xFFFFFFFFu
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define INI_SCAN_WIDTH 16
+#define INI_SCAN_FULL_MASK 0xFFFFu
+#define INI_SCAN_SSE2
+#else
+#define INI_SCAN_WIDTH 32
+#define INI_SCAN_FULL_MASK 0xFFFFFFFFu
+#define INI_SCAN_SCALAR
+#endif
+
+// Storage of variables for each thread
+#if defined(_MSC_VER)
+#define INI_THREAD_LOCAL __declspec(thread)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_THREADS__)
+#define INI_THREAD_LOCAL _Thread_local
+#else
+#define INI_THREAD_LOCAL __thread
+#endif
+
+// Atomic operations
+#if defined(_MSC_VER)
+#define INI_ATOMIC_INCREMENT(ptr) ((unsigned int)_InterlockedIncrement((volatile long *)(ptr)))
+#define INI_ATOMIC_CAS(ptr, expected, desired) (_InterlockedCompareExchange((volatile long *)(ptr), (long)(desired), (long)(expected)) == (long)(expected))
+#if defined(_M_IX86) || defined(_M_X64)
+#define INI_ATOMIC_LOAD_ACQUIRE(ptr) (_ReadWriteBarrier(), *(volatile unsigned int *)(ptr))
+#define INI_ATOMIC_STORE_RELEASE(ptr, value) (_ReadWriteBarrier(), *(volatile unsigned int *)(ptr) = (value))
+#else
+#define INI_ATOMIC_LOAD_ACQUIRE(ptr) ((unsigned int)_InterlockedOr((volatile long *)(ptr), 0))
+#define INI_ATOMIC_STORE_RELEASE(ptr, value) ((void)_InterlockedExchange((volatile long *)(ptr), (long)(value)))
+#endif
+#define INI_ATOMIC_ADD(ptr, value) ((unsigned int)_InterlockedExchangeAdd((volatile long *)(ptr), (long)(value)) + (unsigned int)(value))
+#define INI_ATOMIC_LOAD(ptr) ((unsigned int)_InterlockedOr((volatile long *)(ptr), 0))
+#define INI_ATOMIC_EXCHANGE_POINTER(ptr, value) _InterlockedExchangePointer((void *volatile *)(ptr), (value))
+#define INI_ATOMIC_LOAD_POINTER(ptr) _InterlockedCompareExchangePointer((void *volatile *)(ptr), NULL, NULL)
+#else
+#define INI_ATOMIC_INCREMENT(ptr) __atomic_add_fetch((ptr), 1, __ATOMIC_RELAXED)
+#define INI_ATOMIC_CAS(ptr, expected, desired) __sync_bool_compare_and_swap((ptr), (expected), (desired))
+#define INI_ATOMIC_LOAD_ACQUIRE(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define INI_ATOMIC_STORE_RELEASE(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+#define INI_ATOMIC_ADD(ptr, value) __atomic_add_fetch((ptr), (value), __ATOMIC_SEQ_CST)
+#define INI_ATOMIC_LOAD(ptr) __atomic_load_n((ptr), __ATOMIC_SEQ_CST)
+#define INI_ATOMIC_EXCHANGE_POINTER(ptr, value) __atomic_exchange_n((ptr), (value), __ATOMIC_SEQ_CST)
+#define INI_ATOMIC_LOAD_POINTER(ptr) __atomic_load_n((ptr), __ATOMIC_SEQ_CST)
+#endif
+
+// Hint to load memory in cache before it's used
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define INI_PREFETCH(ptr) _mm_prefetch((const char *)(ptr), _MM_HINT_T0)
+#elif defined(__GNUC__) || defined(__clang__)
+#define INI_PREFETCH(ptr) __builtin_prefetch(ptr)
+#else
+#define INI_PREFETCH(ptr) ((void)(ptr))
+#endif
+
+// Number of queries of batched lookup resolved together, their loads overlap
+#define INI_BATCH_SIZE 16
+
+// States of cache of converted value
+#define INI_CACHE_EMPTY 0u
+#define INI_CACHE_BUSY 1u
+#define INI_CACHE_READY 0x80000000u
+
+// States of section of lazily parsed hash table
+#define INI_LAZY_PENDING 0u
+#define INI_LAZY_LOADED 1u
+#define INI_LAZY_FAILED 2u
+
+// Significant digits of real number kept by exact conversion, the rest only decide rounding
+#define INI_REAL_DIGITS 768
+
+// Words of big integer of exact conversion, enough for 10^1092 shifted by precision of double
+#define INI_BIG_WORDS 128
+
+// Alignment of records of frozen hash table, slots keep their position divided by it
+#define INI_FROZEN_ALIGNMENT 8
+
+// Size of buffer of writer
+#define INI_WRITER_BUFFER_SIZE (1 << 16)
+
+// Minimal size of text parsed by one task of parallel parsing
+#define INI_PARALLEL_CHUNK_SIZE (1 << 20)
+
+// Interval of checking time of modification when file can't be watched
+#define INI_RELOAD_POLL_INTERVAL 1000
+
+// Ticket of reloader without table, its release does nothing
+#define INI_RELOAD_NO_TICKET 2u
+
+// Identification of snapshot, version changes with layout or hash function
+#define INI_SNAPSHOT_MAGIC 0x53494E49u // "INIS" in little endian
+#define INI_SNAPSHOT_VERSION 2u
+#define INI_SNAPSHOT_BYTE_ORDER 0x01020304u
+
+//-----------------------------------------------------------------------------
+// Counters of statistics of parsing, they're compiled only with INI_STATS
+//-----------------------------------------------------------------------------
+
+#ifdef INI_STATS
+#define INI_STAT_ADD(field, value) do { if (s_stats) s_stats->field += (value); } while (0)
+#define INI_STAT_ALLOC(size) do { if (s_stats) { ++s_stats->allocations; s_stats->allocated_bytes += (size); } } while (0)
+#define INI_STAT_CLOCK(name) unsigned long long name = ini_clock()
+#else
+#define INI_STAT_ADD(field, value) ((void)0)
+#define INI_STAT_ALLOC(size) ((void)0)
+#define INI_STAT_CLOCK(name) ((void)0)
+#endif
 
 //-----------------------------------------------------------------------------
 
 typedef enum
 {
 	PARSE_DATA = 0,
-	PARSE_HANDLER
+	PARSE_HANDLER,
+	PARSE_SCHEMA,
+	PARSE_PATCH
 } parse_type_t;
 
-//-----------------------------------------------------------------------------
-
-static int s_ini_last_error_code = INI_NO_ERROR;
-static int s_last_line = -1;
+// Kinds of strings which are written to file
+typedef enum
+{
+	STRING_SECTION = 0,
+	STRING_KEY,
+	STRING_VALUE
+} string_type_t;
 
+//-----------------------------------------------------------------------------
+// Unsigned big integer of exact conversion of real numbers, least significant
+// word first
 //-----------------------------------------------------------------------------
 
-const char *ini_error_messages[] =
+typedef struct
 {
-	"expected identifier of section",
-	"expected end-of-section identifier",
-	"section name is empty",
-	"parameter name is empty",
-	"value of parameter is empty"
-};
+	unsigned int words[INI_BIG_WORDS];
+	size_t count;
+} ini_big_t;
 
 //-----------------------------------------------------------------------------
-// Primitive hash function
+// Layout of snapshot: header, slots, section slots, sections, entries and
+// NUL-terminated strings, positions are offsets from start of file
 //-----------------------------------------------------------------------------
 
-static int ini_get_hash(const char *str, size_t length)
+typedef struct
 {
-	int hash = 0;
+	unsigned int magic;
+	unsigned int version;
+	unsigned int byte_order;
 
-	for (size_t i = 0; i < length; ++i)
-		hash += str[i];
+	// Hash of everything after header
+	unsigned int checksum;
 
-	return hash;
-}
+	unsigned long long size;
 
-//-----------------------------------------------------------------------------
-// Purpose: add entry in the hash table
-//-----------------------------------------------------------------------------
+	unsigned long long slot_count;
+	unsigned long long section_slot_count;
+	unsigned long long section_count;
+	unsigned long long entry_count;
 
-static void ini_add_entry(struct ini_data *data, struct ini_entry *entry)
-{
-	int element = ini_get_hash(entry->key, strlen(entry->key)) % INI_HASH_TABLE_SIZE;
+	unsigned long long slots;
+	unsigned long long section_slots;
+	unsigned long long sections;
+	unsigned long long entries;
+	unsigned long long strings;
+	unsigned long long strings_size;
+} ini_snapshot_header_t;
 
-	struct ini_entry *ent = data->entries[element];
+typedef struct
+{
+	unsigned long long name;
+	unsigned long long length;
+	unsigned int hash;
+	unsigned int reserved;
+} ini_snapshot_section_t;
 
-	if (ent)
-	{
-		data->entries[element] = entry;
-		entry->next = ent;
-	}
-	else
-	{
-		data->entries[element] = entry;
-	}
-}
+typedef struct
+{
+	unsigned long long key;
+	unsigned long long value;
+	unsigned long long key_length;
+	unsigned long long value_length;
+	unsigned int section;
+	unsigned int hash;
+} ini_snapshot_entry_t;
 
 //-----------------------------------------------------------------------------
-// Purpose: check if the character contains at least one character in the array
+// Thread watching file of reloader and lock of reloading
 //-----------------------------------------------------------------------------
 
-static int ini_contains_chars(char ch, const char *chars, size_t length)
+typedef struct
 {
-	for (size_t i = 0; i < length; ++i)
-	{
-		if (chars[i] == ch)
-			return 1;
-	}
+#ifdef _WIN32
+	CRITICAL_SECTION lock;
+	HANDLE thread;
+	HANDLE stopEvent;
+#else
+	pthread_mutex_t lock;
+	pthread_t thread;
+	int stopPipe[2];
+#endif
 
-	return 0;
-}
+	int isWatching;
+} ini_watcher_t;
 
 //-----------------------------------------------------------------------------
+// Body of section in lazily parsed file, text between its header and the next
+// one. Repeated section has several parts chained in order of appearance
 //-----------------------------------------------------------------------------
 
-static char *ini_lstrip(char *str)
+typedef struct
 {
-	while (*str && ini_contains_chars(*str, INI_STRIP_CHARS, INI_STRIP_CHARS_LEN))
-		++str;
+	const char *text;
+	size_t length;
 
-	return str;
-}
+	// Line of header and number of lines of body
+	int line;
+	size_t lines;
 
-//-----------------------------------------------------------------------------
-//-----------------------------------------------------------------------------
+	size_t section;
+
+	// Next part of the same section + 1 (0 - the last one)
+	size_t next;
+} ini_lazy_part_t;
 
-static void ini_rstrip(char *str)
+typedef struct
 {
-	char *end = str + strlen(str) - 1;
+	// The first and the last part + 1 (0 - section has no body)
+	size_t first;
+	size_t last;
 
-	if (end < str)
-		return;
+	unsigned int state;
 
-	while (end >= str && ini_contains_chars(*end, INI_STRIP_CHARS, INI_STRIP_CHARS_LEN))
-	{
-		*end = '\0';
-		--end;
-	}
-}
+	// Error of parsing body, reported on each access
+	int error_code;
+	int line;
+	int column;
+} ini_lazy_section_t;
 
 //-----------------------------------------------------------------------------
+// State of lazily parsed hash table, sections are parsed one at a time under
+// lock and published by their state
 //-----------------------------------------------------------------------------
 
-static char *ini_strip(char *str)
+typedef struct
 {
-	char *result = ini_lstrip(str);
-	ini_rstrip(result);
-	return result;
-}
+	ini_lazy_part_t *parts;
+	size_t part_count;
+	size_t part_capacity;
+
+	// One per section of hash table
+	ini_lazy_section_t *sections;
+
+#ifdef _WIN32
+	CRITICAL_SECTION lock;
+#else
+	pthread_mutex_t lock;
+#endif
+} ini_lazy_t;
 
 //-----------------------------------------------------------------------------
-// Purpose: set NUL-terminator where comment section begins
+// Changes applied to patched file in two passes: the first one finds where
+// parameters are, the second one writes file
 //-----------------------------------------------------------------------------
 
-static void ini_remove_comment(char *str)
+struct ini_patch
 {
-	while (*str && !ini_contains_chars(*str, INI_COMMENT_PREFIX, INI_COMMENT_PREFIX_LEN))
-		++str;
+	const struct ini_data *values;
 
-	if (*str)
-		*str = '\0';
-}
+	// Entries of values found in file
+	char *found;
 
-//-----------------------------------------------------------------------------
-// Purpose: get last error message
-//-----------------------------------------------------------------------------
+	// End of the last parameter line of each section in file (NULL - missing)
+	const char **insertAt;
 
-const char *ini_get_last_error_msg()
-{
-	if (s_ini_last_error_code <= INI_NO_ERROR)
-		return NULL;
+	// Writer of the second pass and end of copied text
+	struct ini_writer *writer;
+	const char *written;
 
-	return ini_error_messages[s_ini_last_error_code];
-}
+	// Newline was added after the last line of file
+	int isTerminated;
+
+	size_t sectionIndex;
+};
 
 //-----------------------------------------------------------------------------
-// Purpose: get last error code
+// Tasks shared by threads, each thread takes the next one until none is left
 //-----------------------------------------------------------------------------
 
-int ini_get_last_error()
+typedef void (*ini_task_fn)(void *task);
+
+typedef struct
 {
-	return s_ini_last_error_code;
-}
+	ini_task_fn function;
+	char *tasks;
+	size_t taskSize;
+	size_t count;
+
+	unsigned int next;
+} ini_task_queue_t;
 
 //-----------------------------------------------------------------------------
-// Purpose: get last line where an error has occurred
+// Part of text parsed in parallel into its own table
 //-----------------------------------------------------------------------------
 
-int ini_get_last_line()
+typedef struct
 {
-	return s_last_line;
-}
+	const char *text;
+	size_t length;
+	int reference;
+
+	// Error and number of lines of this part
+	struct ini_parser parser;
+	int lines;
+	int success;
+
+	struct ini_data data;
+
+#ifdef INI_STATS
+	struct ini_stats stats;
+#endif
+} ini_chunk_t;
 
 //-----------------------------------------------------------------------------
-// Purpose: read data from string
+// Set of strings shared by tables of files loaded by one thread, names which
+// are repeated in files are stored once
 //-----------------------------------------------------------------------------
 
-int ini_read_string(const char *value, struct ini_datatype *datatype, int fieldtype)
+typedef struct
 {
-	switch (fieldtype != -1 ? fieldtype : datatype->fieldtype)
-	{
-	case INI_FIELD_INTEGER:
-		datatype->m_int = atol(value);
-		break;
+	struct ini_string_view *strings;
+	size_t count;
+	size_t capacity;
 
-	case INI_FIELD_INT64:
-		datatype->m_int64 = atoll(value);
-		break;
+	struct ini_slot *slots;
+	size_t slot_count;
+} ini_string_set_t;
 
-	case INI_FIELD_FLOAT:
-		datatype->m_float = strtof(value, NULL);
-		break;
+//-----------------------------------------------------------------------------
+// Thread loading files, it takes the next file until none is left
+//-----------------------------------------------------------------------------
 
-	case INI_FIELD_DOUBLE:
-		datatype->m_double = strtod(value, NULL);
-		break;
+typedef struct
+{
+	struct ini_files *files;
+	unsigned int *next;
 
-	case INI_FIELD_BYTE:
-		datatype->m_byte = (unsigned char)(atol(value) & 0xFF);
-		break;
+	// Strings of loaded files
+	struct ini_arena arena;
+	ini_string_set_t strings;
 
-	case INI_FIELD_CHAR:
-		datatype->m_char = (char)(atoi(value) & 0xFF);
-		break;
+	// Text of the current file
+	char *buffer;
+	size_t bufferSize;
+} ini_loader_t;
 
-	case INI_FIELD_CSTRING:
-		datatype->m_pszString = strdup(value);
-		break;
+//-----------------------------------------------------------------------------
+// Bit masks of characters of scanned block, bit N refers to N-th character
+//-----------------------------------------------------------------------------
 
-	case INI_FIELD_UINT32:
-		datatype->m_uint32 = strtoul(value, NULL, datatype->radix);
-		break;
+typedef struct
+{
+	unsigned int newline;
+	unsigned int comment;
+	unsigned int delimiter;
+	unsigned int space;
+} ini_scan_masks_t;
 
-	case INI_FIELD_UINT64:
-		datatype->m_uint64 = strtoull(value, NULL, datatype->radix);
-		break;
+//-----------------------------------------------------------------------------
+// Classified line: stripped content without comment and first delimiter
+//-----------------------------------------------------------------------------
 
-	case INI_FIELD_BOOL:
-		datatype->m_bool = (!strcmp(value, "false") || !strcmp(value, "0")) ? 0 : 1;
-		break;
+typedef struct
+{
+	const char *start;
+	const char *next;
 
-	default:
-		return 0;
-	}
+	// Content is empty if begin == end
+	const char *begin;
+	const char *end;
 
-	return 1;
-}
+	// First delimiter of key and value (NULL - not found)
+	const char *delimiter;
+} ini_line_t;
 
 //-----------------------------------------------------------------------------
-// Purpose: read data from filled hash table
+// State of parsing shared by all sources of text
 //-----------------------------------------------------------------------------
 
-int ini_read_data(struct ini_data *data, const char *section, const char *key, struct ini_datatype *datatype, int fieldtype)
+typedef struct
 {
-	const char *value = NULL;
+	struct ini_parser *parser;
 
-	int element = ini_get_hash(key, strlen(key)) % INI_HASH_TABLE_SIZE;
-	struct ini_entry *entry = data->entries[element];
+	parse_type_t type;
+	struct ini_data *data;
+	iniHandlerFn handler;
 
-	while (entry != NULL)
-	{
-		if (!strcmp(key, entry->key) && !strcmp(section, entry->section))
-		{
-			value = entry->value;
-			break;
-		}
+	// Structure filled by schema
+	const struct ini_schema *schema;
+	char *object;
 
-		entry = entry->next;
-	}
+	// Entries refer to the source text instead of own copies
+	int reference;
 
-	if (!value)
-		return 0;
+	int line;
+	int parsingSection;
 
-	return ini_read_string(value, datatype, fieldtype);
-}
+	// Start of current line to get column of error
+	const char *lineStart;
 
-//-----------------------------------------------------------------------------
-// Purpose: main function for parsing .ini files
-//-----------------------------------------------------------------------------
+	// Start of next line
+	const char *lineNext;
 
-int ini_parse(const char *filename, parse_type_t type, struct ini_data *data, iniHandlerFn handler)
-{
-	FILE *file = fopen(filename, "r");
+	// Changes of patched file
+	struct ini_patch *patch;
 
-	if (file)
-	{
-		// Zero memory
-		if (type == PARSE_DATA)
-			memset(data, 0, sizeof(struct ini_data));
+	// Names are interned in set shared with other files (NULL - copied)
+	ini_string_set_t *strings;
 
-		int line = 0;
-		int parsingSection = 1;
+	// Current section of hash table
+	const struct ini_section *section;
 
-		static int bufferSize = INI_BUFFER_LENGTH;
-		static char *pszFileBuffer = NULL;
+	// NUL-terminated name of current section passed to handler
+	char *sectionBuffer;
+	size_t sectionBufferSize;
 
-		if (!pszFileBuffer)
-			pszFileBuffer = malloc(bufferSize);
+	// Hash of current section matched by schema
+	size_t sectionLength;
+	unsigned int sectionHash;
 
-		long int endpos;
-		fseek(file, 0, SEEK_END);
-		endpos = ftell(file);
-		rewind(file);
+	// NUL-terminated copies of key and value passed to handler
+	char *scratch;
+	size_t scratchSize;
 
-		const char *pszSection = NULL;
+#ifdef INI_STATS
+	// Statistics collected by the thread before this parsing
+	struct ini_stats *previousStats;
+	unsigned long long startTime;
+#endif
+} ini_parse_state_t;
 
-		// Read line by line
-		while (fgets(pszFileBuffer, bufferSize, file))
-		{
-			size_t length = strlen(pszFileBuffer);
+//-----------------------------------------------------------------------------
+// State of incremental parsing kept in context between chunks of text
+//-----------------------------------------------------------------------------
 
-			// Increase buffer size
-			while (pszFileBuffer[length - 1] != '\n' && ftell(file) != endpos)
-			{
-				bufferSize *= 2;
+typedef struct
+{
+	ini_parse_state_t state;
 
-				void *realloc_mem = realloc(pszFileBuffer, bufferSize);
+	// Length of incomplete line in buffer of context
+	size_t pending;
+} ini_stream_t;
 
-				if (!realloc_mem)
-				{
-					fclose(file);
-					return 0;
-				}
+//-----------------------------------------------------------------------------
 
-				pszFileBuffer = realloc_mem;
-				fgets(pszFileBuffer + length, bufferSize - length, file);
+// Source of generations of hash tables
+static unsigned int s_last_generation = 0;
 
-				length = strlen(pszFileBuffer);
-			}
+// Source of unique names of temporary files
+static unsigned int s_last_temporary = 0;
 
-			++line;
+// Context used by functions without explicit one
+static INI_THREAD_LOCAL struct ini_parser s_default_parser = { NULL, 0, INI_NO_ERROR, -1, -1, 0, NULL, 0, NULL, NULL };
 
-			// Strip string from spaces and comments
-			char *str = ini_lstrip(pszFileBuffer);
-			ini_remove_comment(str);
-			ini_rstrip(str);
+#ifdef INI_STATS
+// Statistics of parsing running on this thread
+static INI_THREAD_LOCAL struct ini_stats *s_stats = NULL;
 
-			// Nothing here, skip
-			if (!*str)
-				continue;
+//-----------------------------------------------------------------------------
+// Purpose: get monotonic time in nanoseconds
+//-----------------------------------------------------------------------------
 
-			// Parsing section
-			if (parsingSection)
-			{
-			PARSE_SECTION:
-				if (*str == INI_SECTION_PREFIX)
-				{
-					char *end = str + strlen(str) - 1;
-
-					// Exclude prefix of section
-					++str;
-
-					if (*end == INI_SECTION_POSTFIX)
-					{
-						// Exclude postfix of section
-						*end = '\0';
-
-						// Strip
-						str = ini_strip(str);
-
-						if (*str)
-						{
-							// Next try to parse parameters
-							parsingSection = 0;
-
-							// Free previous name of section
-							if (pszSection)
-								free((void *)pszSection);
-							
-							// Save name of section
-							pszSection = strdup(str);
-						}
-						else
-						{
-							s_ini_last_error_code = INI_ERROR_SECTION_EMPTY;
-							s_last_line = line;
-							return 0;
-						}
-					}
-					else
-					{
-						s_ini_last_error_code = INI_ERROR_SECTION_END_ID;
-						s_last_line = line;
-						return 0;
-					}
-				}
-				else
-				{
-					s_ini_last_error_code = INI_ERROR_SECTION_START_ID;
-					s_last_line = line;
-					return 0;
-				}
-			}
-			else
-			{
-				// Found prefix of section, start parsing a new one
-				if (*str == INI_SECTION_PREFIX)
-				{
-					parsingSection = 1;
-					goto PARSE_SECTION;
-				}
+static unsigned long long ini_clock()
+{
+#ifdef _WIN32
+	LARGE_INTEGER frequency, counter;
 
-				// Split parameter
-				char *key = strtok(str, INI_PARAMETER_DELIMITER);
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
 
-				if (!key || !*key)
-				{
-					s_ini_last_error_code = INI_ERROR_KEY_EMPTY;
-					s_last_line = line;
-					return 0;
-				}
+	return (unsigned long long)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+	// Strict ISO C mode hides POSIX clocks, only clocks of standard C are left then
+#if defined(CLOCK_MONOTONIC)
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
 
-				char *value = strtok(NULL, INI_PARAMETER_DELIMITER);
+	return (unsigned long long)time.tv_sec * 1000000000ULL + (unsigned long long)time.tv_nsec;
+#elif defined(TIME_UTC)
+	struct timespec time;
+	timespec_get(&time, TIME_UTC);
 
-				if (!value || !*value)
-				{
-					s_ini_last_error_code = INI_ERROR_VALUE_EMPTY;
-					s_last_line = line;
-					return 0;
-				}
+	return (unsigned long long)time.tv_sec * 1000000000ULL + (unsigned long long)time.tv_nsec;
+#else
+	return (unsigned long long)((double)clock() * 1e9 / CLOCKS_PER_SEC);
+#endif
+#endif
+}
+#endif
 
-				// Strip
-				ini_rstrip(key);
-				value = ini_strip(value);
+//-----------------------------------------------------------------------------
 
-				if (type == PARSE_DATA)
-				{
-					// Fill our hash table
-					struct ini_entry *entry = calloc(1, sizeof(struct ini_entry));
+const char *ini_error_messages[] =
+{
+	"expected identifier of section",
+	"expected end-of-section identifier",
+	"section name is empty",
+	"parameter name is empty",
+	"value of parameter is empty",
+	"value of parameter doesn't match its type",
+	"value of parameter is out of range of its type",
+	"unknown field type",
+	"buffer is too small for value",
+	"snapshot is damaged or incompatible",
+	"failed to write file",
+	"string can't be written to .ini file",
+	"parameter not found",
+	"out of memory"
+};
 
-					entry->key = strdup(key);
-					entry->value = strdup(value);
-					entry->section = strdup(pszSection);
+//-----------------------------------------------------------------------------
+// Hash function: mixes 8 bytes per step, seed lets to chain section and key
+//-----------------------------------------------------------------------------
 
-					ini_add_entry(data, entry);
-				}
-				else if (type == PARSE_HANDLER)
-				{
-					// Call our callback
-					handler(pszSection, key, value);
-				}
-			}
-		}
+static unsigned int ini_hash(const char *str, size_t length, unsigned int seed)
+{
+	const unsigned long long k1 = 0x9E3779B97F4A7C15ULL;
+	const unsigned long long k2 = 0xC2B2AE3D27D4EB4FULL;
 
-		// Free allocated memory
-		if (pszSection)
-			free((void *)pszSection);
+	unsigned long long hash = ((unsigned long long)seed + k2) ^ ((unsigned long long)length * k1);
+	unsigned long long word;
 
-		fclose(file);
+	while (length >= 8)
+	{
+		memcpy(&word, str, 8);
 
-		s_ini_last_error_code = INI_NO_ERROR;
-		s_last_line = -1;
+		hash ^= word * k1;
+		hash = ((hash << 31) | (hash >> 33)) * k2;
 
-		return 1;
+		str += 8;
+		length -= 8;
 	}
-	else
+
+	if (length)
 	{
-		s_ini_last_error_code = INI_MISSING_FILE;
-		return 0;
+		word = 0;
+		memcpy(&word, str, length);
+
+		hash ^= word * k1;
+		hash = ((hash << 31) | (hash >> 33)) * k2;
 	}
+
+	// Finalizer of MurmurHash3
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDULL;
+	hash ^= hash >> 33;
+	hash *= 0xC4CEB9FE1A85EC53ULL;
+	hash ^= hash >> 33;
+
+	return (unsigned int)hash;
 }
 
 //-----------------------------------------------------------------------------
-// Purpose: wrapper to save .ini data in hash table
+// Purpose: get unique generation of hash table, 0 is never used
 //-----------------------------------------------------------------------------
 
-int ini_parse_data(const char *filename, struct ini_data *data)
+static unsigned int ini_next_generation()
 {
-	return ini_parse(filename, PARSE_DATA, data, NULL);
+	unsigned int generation = INI_ATOMIC_INCREMENT(&s_last_generation);
+
+	if (generation == 0)
+		generation = INI_ATOMIC_INCREMENT(&s_last_generation);
+
+	return generation;
 }
 
 //-----------------------------------------------------------------------------
-// Purpose: wrapper to call a callback when parse .ini file
+// Purpose: put element in open addressing index, slot must be absent
 //-----------------------------------------------------------------------------
 
-int ini_parse_handler(const char *filename, iniHandlerFn handler)
+static void ini_slot_insert(struct ini_slot *slots, size_t slotCount, unsigned int hash, unsigned int index)
 {
-	return ini_parse(filename, PARSE_HANDLER, NULL, handler);
+	size_t mask = slotCount - 1;
+	size_t i = hash & mask;
+
+	while (slots[i].index)
+		i = (i + 1) & mask;
+
+	// Index is published after hash, lazily parsed table is probed while it's filled
+	slots[i].hash = hash;
+	INI_ATOMIC_STORE_RELEASE(&slots[i].index, index);
 }
 
 //-----------------------------------------------------------------------------
-// Purpose: free allocated memory from hash table
+// Purpose: grow open addressing index to keep load factor below 3/4
 //-----------------------------------------------------------------------------
 
-void ini_free_data(struct ini_data *data, int is_allocated)
+static int ini_reserve_slots(struct ini_slot **slots, size_t *slotCount, size_t count)
 {
-	for (size_t i = 0; i < INI_HASH_TABLE_SIZE; ++i)
-	{
-		struct ini_entry *entry = data->entries[i];
+	if (*slots && (count + 1) * 4 <= *slotCount * 3)
+		return 1;
 
-		while (entry != NULL)
-		{
-			struct ini_entry *prev = entry;
-			entry = entry->next;
+	size_t newCount = *slotCount ? *slotCount : INI_HASH_TABLE_SIZE;
 
-			free((void *)prev->key);
-			free((void *)prev->value);
-			free((void *)prev->section);
-			free(prev);
-		}
+	while ((count + 1) * 4 > newCount * 3)
+		newCount *= 2;
+
+	struct ini_slot *newSlots = calloc(newCount, sizeof(struct ini_slot));
+
+	if (!newSlots)
+		return 0;
+
+	INI_STAT_ALLOC(newCount * sizeof(struct ini_slot));
+
+	// Stored hashes, no need to touch elements
+	for (size_t i = 0; i < *slotCount; ++i)
+	{
+		if ((*slots)[i].index)
+			ini_slot_insert(newSlots, newCount, (*slots)[i].hash, (*slots)[i].index);
 	}
 
-	if (is_allocated)
-		free(data);
+	free(*slots);
+
+	*slots = newSlots;
+	*slotCount = newCount;
+
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: find interned section in the hash table
+//-----------------------------------------------------------------------------
+
+static struct ini_section *ini_find_section(const struct ini_data *data, const char *name, size_t length, unsigned int hash)
+{
+	if (!data->section_slots)
+		return NULL;
+
+	size_t mask = data->section_slot_count - 1;
+	size_t i = hash & mask;
+
+	while (data->section_slots[i].index)
+	{
+		if (data->section_slots[i].hash == hash)
+		{
+			struct ini_section *section = data->sections[data->section_slots[i].index - 1];
+
+			if (section->length == length && !memcmp(name, section->name, length))
+				return section;
+		}
+
+		i = (i + 1) & mask;
+	}
+
+	return NULL;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: find entry in the hash table
+//-----------------------------------------------------------------------------
+
+static struct ini_entry *ini_find_entry(const struct ini_data *data, const struct ini_section *section, const char *key, size_t keyLength, unsigned int hash)
+{
+	if (!data->slots)
+		return NULL;
+
+	size_t mask = data->slot_count - 1;
+	size_t i = hash & mask;
+	unsigned int index;
+
+	while ((index = INI_ATOMIC_LOAD_ACQUIRE(&data->slots[i].index)))
+	{
+		if (data->slots[i].hash == hash)
+		{
+			struct ini_entry *entry = &data->entries[index - 1];
+
+			// Entries refer to interned section, so compare only its identity
+			if (entry->section == section && entry->key_length == keyLength && !memcmp(key, entry->key, keyLength))
+				return entry;
+		}
+
+		i = (i + 1) & mask;
+	}
+
+	return NULL;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: add entry in the hash table, value of existing one is replaced
+//-----------------------------------------------------------------------------
+
+static int ini_add_entry(struct ini_data *data, const struct ini_entry *entry)
+{
+	struct ini_entry *ent = ini_find_entry(data, entry->section, entry->key, entry->key_length, entry->hash);
+
+	if (ent)
+	{
+		ent->value = entry->value;
+		ent->value_length = entry->value_length;
+		ent->cache_state = INI_CACHE_EMPTY;
+		return 1;
+	}
+
+	if (data->entry_count == data->entry_capacity)
+	{
+		size_t capacity = data->entry_capacity ? data->entry_capacity * 2 : INI_HASH_TABLE_SIZE;
+		void *realloc_mem = realloc(data->entries, capacity * sizeof(struct ini_entry));
+
+		if (!realloc_mem)
+			return 0;
+
+		INI_STAT_ALLOC(capacity * sizeof(struct ini_entry));
+
+		data->entries = realloc_mem;
+		data->entry_capacity = capacity;
+
+		// Entries have moved, handles must be resolved again
+		data->generation = ini_next_generation();
+	}
+
+	if (!ini_reserve_slots(&data->slots, &data->slot_count, data->entry_count))
+		return 0;
+
+	data->entries[data->entry_count++] = *entry;
+	ini_slot_insert(data->slots, data->slot_count, entry->hash, (unsigned int)data->entry_count);
+
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: make entries of each section contiguous keeping their order, file
+// without repeated sections is grouped already and isn't moved
+//
+// Return value: 1 - success, 0 - failed to allocate memory or entries must be
+// moved but they can't
+//-----------------------------------------------------------------------------
+
+static int ini_index_sections(struct ini_data *data, int canMove)
+{
+	int isGrouped = 1;
+	const struct ini_section *previous = NULL;
+
+	for (size_t i = 0; i < data->section_count; ++i)
+	{
+		data->sections[i]->first = 0;
+		data->sections[i]->count = 0;
+	}
+
+	for (size_t i = 0; i < data->entry_count; ++i)
+	{
+		struct ini_section *section = data->sections[data->entries[i].section->index];
+
+		if (!section->count)
+			section->first = i;
+		else if (section != previous)
+			isGrouped = 0;
+
+		++section->count;
+		previous = section;
+	}
+
+	if (isGrouped)
+		return 1;
+
+	if (!canMove)
+		return 0;
+
+	struct ini_entry *entries = malloc(data->entry_capacity * sizeof(struct ini_entry));
+
+	if (!entries)
+		return 0;
+
+	INI_STAT_ALLOC(data->entry_capacity * sizeof(struct ini_entry));
+
+	// Stable counting sort by sections in order of their appearance
+	size_t first = 0;
+
+	for (size_t i = 0; i < data->section_count; ++i)
+	{
+		data->sections[i]->first = first;
+		first += data->sections[i]->count;
+		data->sections[i]->count = 0;
+	}
+
+	for (size_t i = 0; i < data->entry_count; ++i)
+	{
+		struct ini_section *section = data->sections[data->entries[i].section->index];
+		entries[section->first + section->count++] = data->entries[i];
+	}
+
+	free(data->entries);
+	data->entries = entries;
+
+	// Stored hashes, no need to touch strings
+	memset(data->slots, 0, data->slot_count * sizeof(struct ini_slot));
+
+	for (size_t i = 0; i < data->entry_count; ++i)
+		ini_slot_insert(data->slots, data->slot_count, entries[i].hash, (unsigned int)(i + 1));
+
+	// Entries have moved, handles must be resolved again
+	data->generation = ini_next_generation();
+
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: check if the character contains at least one character in the array
+//-----------------------------------------------------------------------------
+
+static int ini_contains_chars(char ch, const char *chars, size_t length)
+{
+	for (size_t i = 0; i < length; ++i)
+	{
+		if (chars[i] == ch)
+			return 1;
+	}
+
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+static const char *ini_lstrip(const char *str, const char *end)
+{
+	while (str < end && ini_contains_chars(*str, INI_STRIP_CHARS, INI_STRIP_CHARS_LEN))
+		++str;
+
+	return str;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+static const char *ini_rstrip(const char *str, const char *end)
+{
+	while (end > str && ini_contains_chars(*(end - 1), INI_STRIP_CHARS, INI_STRIP_CHARS_LEN))
+		--end;
+
+	return end;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: index of lowest set bit, mask must not be zero
+//-----------------------------------------------------------------------------
+
+static unsigned int ini_bit_first(unsigned int mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (unsigned int)index;
+#else
+	return (unsigned int)__builtin_ctz(mask);
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: index of highest set bit, mask must not be zero
+//-----------------------------------------------------------------------------
+
+static unsigned int ini_bit_last(unsigned int mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanReverse(&index, mask);
+	return (unsigned int)index;
+#else
+	return 31u - (unsigned int)__builtin_clz(mask);
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: classify characters of block shorter than INI_SCAN_WIDTH one by one
+//-----------------------------------------------------------------------------
+
+static void ini_scan_block_scalar(const char *str, size_t length, ini_scan_masks_t *masks)
+{
+	memset(masks, 0, sizeof(ini_scan_masks_t));
+
+	for (size_t i = 0; i < length; ++i)
+	{
+		const unsigned int bit = 1u << i;
+		const char ch = str[i];
+
+		if (ch == '\n')
+			masks->newline |= bit;
+
+		if (ini_contains_chars(ch, INI_COMMENT_PREFIX, INI_COMMENT_PREFIX_LEN))
+			masks->comment |= bit;
+
+		if (ch == INI_PARAMETER_DELIMITER_CHAR)
+			masks->delimiter |= bit;
+
+		if (ini_contains_chars(ch, INI_STRIP_CHARS, INI_STRIP_CHARS_LEN))
+			masks->space |= bit;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: classify INI_SCAN_WIDTH characters at once
+//-----------------------------------------------------------------------------
+
+static void ini_scan_block(const char *str, ini_scan_masks_t *masks)
+{
+#if defined(__AVX2__)
+	const __m256i block = _mm256_loadu_si256((const __m256i *)str);
+
+	__m256i comment = _mm256_setzero_si256();
+	__m256i space = _mm256_setzero_si256();
+
+	for (size_t i = 0; i < INI_COMMENT_PREFIX_LEN; ++i)
+		comment = _mm256_or_si256(comment, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(INI_COMMENT_PREFIX[i])));
+
+	for (size_t i = 0; i < INI_STRIP_CHARS_LEN; ++i)
+		space = _mm256_or_si256(space, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(INI_STRIP_CHARS[i])));
+
+	masks->newline = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('\n')));
+	masks->comment = (unsigned int)_mm256_movemask_epi8(comment);
+	masks->delimiter = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(INI_PARAMETER_DELIMITER_CHAR)));
+	masks->space = (unsigned int)_mm256_movemask_epi8(space);
+#elif defined(INI_SCAN_SSE2)
+	const __m128i block = _mm_loadu_si128((const __m128i *)str);
+
+	__m128i comment = _mm_setzero_si128();
+	__m128i space = _mm_setzero_si128();
+
+	for (size_t i = 0; i < INI_COMMENT_PREFIX_LEN; ++i)
+		comment = _mm_or_si128(comment, _mm_cmpeq_epi8(block, _mm_set1_epi8(INI_COMMENT_PREFIX[i])));
+
+	for (size_t i = 0; i < INI_STRIP_CHARS_LEN; ++i)
+		space = _mm_or_si128(space, _mm_cmpeq_epi8(block, _mm_set1_epi8(INI_STRIP_CHARS[i])));
+
+	masks->newline = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8('\n')));
+	masks->comment = (unsigned int)_mm_movemask_epi8(comment);
+	masks->delimiter = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8(INI_PARAMETER_DELIMITER_CHAR)));
+	masks->space = (unsigned int)_mm_movemask_epi8(space);
+#else
+	ini_scan_block_scalar(str, INI_SCAN_WIDTH, masks);
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: find end of line, start of comment, first delimiter and bounds of
+// content in a single pass over blocks of text
+//-----------------------------------------------------------------------------
+
+static void ini_scan_line(const char *str, const char *end, ini_line_t *line)
+{
+	const char *first = NULL;
+	const char *last = NULL;
+
+	ini_scan_masks_t masks;
+
+	line->start = str;
+	line->next = end;
+	line->delimiter = NULL;
+
+	while (str < end)
+	{
+		size_t length = end - str;
+		unsigned int valid = INI_SCAN_FULL_MASK;
+
+		if (length >= INI_SCAN_WIDTH)
+		{
+			ini_scan_block(str, &masks);
+			length = INI_SCAN_WIDTH;
+		}
+		else
+		{
+			ini_scan_block_scalar(str, length, &masks);
+			valid = (1u << length) - 1;
+		}
+
+		// Content ends on line break or comment
+		const unsigned int stop = masks.newline | masks.comment;
+
+		if (stop)
+			valid &= (stop & (0u - stop)) - 1;
+
+		const unsigned int content = ~masks.space & valid;
+
+		if (content)
+		{
+			if (!first)
+				first = str + ini_bit_first(content);
+
+			last = str + ini_bit_last(content);
+		}
+
+		if (!line->delimiter && (masks.delimiter & valid))
+			line->delimiter = str + ini_bit_first(masks.delimiter & valid);
+
+		if (stop)
+		{
+			// Skip the rest of commented line
+			if (masks.newline)
+			{
+				line->next = str + ini_bit_first(masks.newline) + 1;
+			}
+			else
+			{
+				const char *lineEnd = memchr(str + length, '\n', end - (str + length));
+				line->next = lineEnd ? lineEnd + 1 : end;
+			}
+
+			break;
+		}
+
+		str += length;
+	}
+
+	line->begin = first ? first : line->start;
+	line->end = last ? last + 1 : line->start;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: find delimiter of key and value
+//-----------------------------------------------------------------------------
+
+static const char *ini_find_delimiter(const char *str, const char *end)
+{
+	const char *delimiter = memchr(str, INI_PARAMETER_DELIMITER_CHAR, end - str);
+	return delimiter ? delimiter : end;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: grow buffer to fit the given size
+//-----------------------------------------------------------------------------
+
+static int ini_reserve(char **buffer, size_t *size, size_t required)
+{
+	if (*size >= required)
+		return 1;
+
+	size_t newSize = *size ? *size : INI_BUFFER_LENGTH;
+
+	while (newSize < required)
+		newSize *= 2;
+
+	void *realloc_mem = realloc(*buffer, newSize);
+
+	if (!realloc_mem)
+		return 0;
+
+	INI_STAT_ALLOC(newSize);
+
+	*buffer = realloc_mem;
+	*size = newSize;
+
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: allocate memory from arena, alignment must be power of two
+//-----------------------------------------------------------------------------
+
+static void *ini_arena_alloc(struct ini_arena *arena, size_t size, size_t alignment)
+{
+	struct ini_arena_chunk *chunk = arena->head;
+	const size_t header = (sizeof(struct ini_arena_chunk) + INI_ARENA_ALIGNMENT - 1) & ~(INI_ARENA_ALIGNMENT - 1);
+
+	if (chunk)
+	{
+		size_t offset = (chunk->used + alignment - 1) & ~(alignment - 1);
+
+		if (offset + size <= chunk->size)
+		{
+			chunk->used = offset + size;
+			arena->used += size;
+
+			return (char *)chunk + header + offset;
+		}
+	}
+
+	// Chunks grow with the arena, large blocks get their own chunk
+	size_t chunkSize = arena->reserved < INI_ARENA_CHUNK_SIZE ? INI_ARENA_CHUNK_SIZE : arena->reserved;
+
+	if (chunkSize > INI_ARENA_CHUNK_SIZE * 64)
+		chunkSize = INI_ARENA_CHUNK_SIZE * 64;
+
+	int isDedicated = (size + alignment > chunkSize / 4);
+
+	if (isDedicated)
+		chunkSize = size + alignment;
+
+	struct ini_arena_chunk *newChunk = malloc(header + chunkSize);
+
+	if (!newChunk)
+		return NULL;
+
+	INI_STAT_ALLOC(header + chunkSize);
+
+	newChunk->size = chunkSize;
+	newChunk->used = size;
+
+	// Keep free space of current chunk for next allocations
+	if (isDedicated && chunk)
+	{
+		newChunk->next = chunk->next;
+		chunk->next = newChunk;
+	}
+	else
+	{
+		newChunk->next = chunk;
+		arena->head = newChunk;
+	}
+
+	arena->used += size;
+	arena->reserved += chunkSize;
+
+	return (char *)newChunk + header;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: copy string of known length in arena
+//-----------------------------------------------------------------------------
+
+static char *ini_arena_strndup(struct ini_arena *arena, const char *str, size_t length)
+{
+	char *copy = ini_arena_alloc(arena, length + 1, 1);
+
+	if (copy)
+	{
+		memcpy(copy, str, length);
+		copy[length] = '\0';
+	}
+
+	return copy;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: release all chunks of arena
+//-----------------------------------------------------------------------------
+
+static void ini_arena_free(struct ini_arena *arena)
+{
+	struct ini_arena_chunk *chunk = arena->head;
+
+	while (chunk != NULL)
+	{
+		struct ini_arena_chunk *prev = chunk;
+		chunk = chunk->next;
+
+		free(prev);
+	}
+
+	arena->head = NULL;
+	arena->used = 0;
+	arena->reserved = 0;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: get section from the hash table or add it once
+//-----------------------------------------------------------------------------
+
+static struct ini_section *ini_intern_section(struct ini_data *data, const char *name, size_t length, int reference)
+{
+	unsigned int hash = ini_hash(name, length, 0);
+	struct ini_section *section = ini_find_section(data, name, length, hash);
+
+	if (section)
+		return section;
+
+	if (data->section_count == data->section_capacity)
+	{
+		size_t capacity = data->section_capacity ? data->section_capacity * 2 : INI_HASH_TABLE_SIZE;
+		void *realloc_mem = realloc(data->sections, capacity * sizeof(struct ini_section *));
+
+		if (!realloc_mem)
+			return NULL;
+
+		INI_STAT_ALLOC(capacity * sizeof(struct ini_section *));
+
+		data->sections = realloc_mem;
+		data->section_capacity = capacity;
+	}
+
+	if (!ini_reserve_slots(&data->section_slots, &data->section_slot_count, data->section_count))
+		return NULL;
+
+	section = ini_arena_alloc(&data->arena, sizeof(struct ini_section), INI_ARENA_ALIGNMENT);
+
+	if (!section)
+		return NULL;
+
+	section->name = reference ? name : ini_arena_strndup(&data->arena, name, length);
+	section->length = length;
+	section->hash = hash;
+	section->index = data->section_count;
+	section->first = 0;
+	section->count = 0;
+
+	if (!section->name)
+		return NULL;
+
+	data->sections[data->section_count++] = section;
+	ini_slot_insert(data->section_slots, data->section_slot_count, hash, (unsigned int)data->section_count);
+
+	return section;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: get string from set or copy it in arena and add it once
+//-----------------------------------------------------------------------------
+
+static const char *ini_intern_string(ini_string_set_t *set, struct ini_arena *arena, const char *str, size_t length)
+{
+	unsigned int hash = ini_hash(str, length, 0);
+
+	if (set->slots)
+	{
+		size_t mask = set->slot_count - 1;
+
+		for (size_t i = hash & mask; set->slots[i].index; i = (i + 1) & mask)
+		{
+			const struct ini_string_view *string = &set->strings[set->slots[i].index - 1];
+
+			if (set->slots[i].hash == hash && string->length == length && !memcmp(string->string, str, length))
+				return string->string;
+		}
+	}
+
+	if (set->count == set->capacity)
+	{
+		size_t capacity = set->capacity ? set->capacity * 2 : INI_HASH_TABLE_SIZE;
+		void *realloc_mem = realloc(set->strings, capacity * sizeof(struct ini_string_view));
+
+		if (!realloc_mem)
+			return NULL;
+
+		INI_STAT_ALLOC(capacity * sizeof(struct ini_string_view));
+
+		set->strings = realloc_mem;
+		set->capacity = capacity;
+	}
+
+	if (!ini_reserve_slots(&set->slots, &set->slot_count, set->count))
+		return NULL;
+
+	char *copy = ini_arena_strndup(arena, str, length);
+
+	if (!copy)
+		return NULL;
+
+	set->strings[set->count].string = copy;
+	set->strings[set->count].length = length;
+
+	ini_slot_insert(set->slots, set->slot_count, hash, (unsigned int)++set->count);
+
+	return copy;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: map whole file in memory for reading
+//-----------------------------------------------------------------------------
+
+static int ini_map_file(const char *filename, void **mapping, size_t *size)
+{
+	*mapping = NULL;
+	*size = 0;
+
+#ifdef _WIN32
+	HANDLE hFile = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+	if (hFile == INVALID_HANDLE_VALUE)
+		return 0;
+
+	LARGE_INTEGER fileSize;
+
+	if (!GetFileSizeEx(hFile, &fileSize) || (unsigned long long)fileSize.QuadPart > (size_t)-1)
+	{
+		CloseHandle(hFile);
+		return 0;
+	}
+
+	// Nothing to map
+	if (fileSize.QuadPart == 0)
+	{
+		CloseHandle(hFile);
+		return 1;
+	}
+
+	HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(hFile);
+
+	if (!hMapping)
+		return 0;
+
+	void *view = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(hMapping);
+
+	if (!view)
+		return 0;
+
+	*mapping = view;
+	*size = (size_t)fileSize.QuadPart;
+#else
+	int fd = open(filename, O_RDONLY);
+
+	if (fd == -1)
+		return 0;
+
+	struct stat st;
+
+	if (fstat(fd, &st) == -1 || (unsigned long long)st.st_size > (size_t)-1)
+	{
+		close(fd);
+		return 0;
+	}
+
+	// Nothing to map
+	if (st.st_size == 0)
+	{
+		close(fd);
+		return 1;
+	}
+
+	void *view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (view == MAP_FAILED)
+		return 0;
+
+#ifdef MADV_SEQUENTIAL
+	madvise(view, (size_t)st.st_size, MADV_SEQUENTIAL);
+#endif
+
+	*mapping = view;
+	*size = (size_t)st.st_size;
+#endif
+
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: release mapped file
+//-----------------------------------------------------------------------------
+
+static void ini_unmap_file(void *mapping, size_t size)
+{
+	if (!mapping)
+		return;
+
+#ifdef _WIN32
+	(void)size;
+	UnmapViewOfFile(mapping);
+#else
+	munmap(mapping, size);
+#endif
+}
+
+static int ini_convert(const char *value, size_t length, struct ini_datatype *datatype, int fieldtype);
+static int ini_default_result(int error);
+static int ini_convert_entries(struct ini_data *data, const struct ini_typed_key *types, size_t count);
+static int ini_load_section(struct ini_data *data, const struct ini_section *section);
+static int ini_patch_section(ini_parse_state_t *state, const char *section, size_t length);
+static int ini_patch_parameter(ini_parse_state_t *state, const char *key, size_t keyLength, const char *value, size_t valueLength);
+
+//-----------------------------------------------------------------------------
+// Purpose: get position of hash in perfect hash table of schema
+//-----------------------------------------------------------------------------
+
+static inline size_t ini_schema_position(unsigned int hash, unsigned int seed, unsigned int shift)
+{
+	return (size_t)(((hash ^ seed) * 0x9E3779B1u) >> shift);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: find field of schema by section and key
+//-----------------------------------------------------------------------------
+
+static const struct ini_schema_field *ini_schema_find(const struct ini_schema *schema, unsigned int sectionHash, const char *section, size_t sectionLength, const char *key, size_t keyLength)
+{
+	if (!schema->field_count)
+		return NULL;
+
+	unsigned int hash = ini_hash(key, keyLength, sectionHash);
+	const struct ini_slot *slot = &schema->slots[ini_schema_position(hash, schema->seed, schema->shift)];
+
+	if (!slot->index || slot->hash != hash)
+		return NULL;
+
+	// Hashes match, check names, fields with the same hash are chained
+	for (unsigned int index = slot->index; index; index = schema->chain ? schema->chain[index - 1] : 0)
+	{
+		const struct ini_schema_field *field = &schema->fields[index - 1];
+
+		if (!strncmp(field->section, section, sectionLength) && field->section[sectionLength] == '\0' &&
+			!strncmp(field->key, key, keyLength) && field->key[keyLength] == '\0')
+		{
+			return field;
+		}
+	}
+
+	return NULL;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: get size of member of structure to store field type (0 - unsupported)
+//-----------------------------------------------------------------------------
+
+static size_t ini_field_size(int fieldtype)
+{
+	struct ini_datatype datatype;
+
+	switch (fieldtype)
+	{
+	case INI_FIELD_INTEGER: return sizeof(datatype.m_int);
+	case INI_FIELD_INT64: return sizeof(datatype.m_int64);
+	case INI_FIELD_FLOAT: return sizeof(datatype.m_float);
+	case INI_FIELD_DOUBLE: return sizeof(datatype.m_double);
+	case INI_FIELD_BYTE: return sizeof(datatype.m_byte);
+	case INI_FIELD_CHAR: return sizeof(datatype.m_char);
+	case INI_FIELD_CSTRING: return sizeof(datatype.m_pszString);
+	case INI_FIELD_UINT32: return sizeof(datatype.m_uint32);
+	case INI_FIELD_UINT64: return sizeof(datatype.m_uint64);
+	case INI_FIELD_BOOL: return sizeof(datatype.m_bool);
+
+	// Text of views doesn't outlive parsing
+	default: return 0;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: convert value and store it in member of structure
+//
+// Return value: INI_NO_ERROR or error code of conversion
+//-----------------------------------------------------------------------------
+
+static int ini_store_field(char *object, const struct ini_schema_field *field, const char *value, size_t length)
+{
+	struct ini_datatype datatype;
+
+	datatype.fieldtype = field->fieldtype;
+	datatype.radix = field->radix;
+
+	int error = ini_convert(value, length, &datatype, -1);
+
+	if (error != INI_NO_ERROR)
+		return error;
+
+	// Repeated parameter replaces its string
+	if (field->fieldtype == INI_FIELD_CSTRING)
+	{
+		char *previous;
+
+		memcpy(&previous, object + field->offset, sizeof(previous));
+		free(previous);
+	}
+
+	// Members of union start at the same address
+	memcpy(object + field->offset, &datatype.m_uint64, ini_field_size(field->fieldtype));
+
+	return INI_NO_ERROR;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: compile schema, build perfect hash of its parameters
+//-----------------------------------------------------------------------------
+
+int ini_schema_compile(struct ini_schema *schema, const struct ini_schema_field *fields, size_t count)
+{
+	memset(schema, 0, sizeof(struct ini_schema));
+
+	if (!count)
+	{
+		schema->fields = fields;
+		return 1;
+	}
+
+	unsigned int *hashes = malloc(count * sizeof(unsigned int));
+	unsigned int *chain = calloc(count, sizeof(unsigned int));
+
+	// Fields which are the first of their hash get slots
+	unsigned char *isFirst = malloc(count);
+
+	if (!hashes || !chain || !isFirst)
+	{
+		free(hashes);
+		free(chain);
+		free(isFirst);
+
+		return ini_default_result(INI_ERROR_OUT_OF_MEMORY);
+	}
+
+	int error = INI_NO_ERROR;
+	int isChained = 0;
+
+	for (size_t i = 0; error == INI_NO_ERROR && i < count; ++i)
+	{
+		if (!ini_field_size(fields[i].fieldtype))
+		{
+			error = INI_ERROR_INVALID_FIELD_TYPE;
+			break;
+		}
+
+		hashes[i] = ini_hash(fields[i].key, strlen(fields[i].key), ini_hash(fields[i].section, strlen(fields[i].section), 0));
+		isFirst[i] = 1;
+
+		// Equal hashes can't be separated by any seed, different names with them are chained
+		for (size_t j = 0; j < i; ++j)
+		{
+			if (hashes[j] != hashes[i])
+				continue;
+
+			if (!strcmp(fields[j].section, fields[i].section) && !strcmp(fields[j].key, fields[i].key))
+			{
+				error = INI_ERROR_INVALID_STRING;
+				break;
+			}
+
+			if (isFirst[j])
+			{
+				size_t last = j;
+
+				while (chain[last])
+					last = chain[last] - 1;
+
+				chain[last] = (unsigned int)i + 1;
+				isFirst[i] = 0;
+				isChained = 1;
+			}
+		}
+	}
+
+	// Start with load factor below 1/2, grow the table if no seed fits
+	unsigned int bits = 1;
+
+	while (((size_t)1 << bits) < count * 2)
+		++bits;
+
+	struct ini_slot *slots = NULL;
+	unsigned int seed = 0;
+
+	for (; error == INI_NO_ERROR && !seed && bits < 32; ++bits)
+	{
+		size_t slotCount = (size_t)1 << bits;
+		unsigned int shift = 32 - bits;
+
+		if (!(slots = malloc(slotCount * sizeof(struct ini_slot))))
+			break;
+
+		for (seed = 1; seed <= 256; ++seed)
+		{
+			size_t i;
+
+			memset(slots, 0, slotCount * sizeof(struct ini_slot));
+
+			for (i = 0; i < count; ++i)
+			{
+				if (!isFirst[i])
+					continue;
+
+				struct ini_slot *slot = &slots[ini_schema_position(hashes[i], seed, shift)];
+
+				if (slot->index)
+					break;
+
+				slot->hash = hashes[i];
+				slot->index = (unsigned int)i + 1;
+			}
+
+			if (i == count)
+			{
+				schema->shift = shift;
+				break;
+			}
+		}
+
+		if (seed > 256)
+		{
+			free(slots);
+			slots = NULL;
+			seed = 0;
+		}
+	}
+
+	// Table grows until allocation fails
+	if (error == INI_NO_ERROR && !slots)
+		error = INI_ERROR_OUT_OF_MEMORY;
+
+	free(hashes);
+	free(isFirst);
+
+	if (error != INI_NO_ERROR)
+	{
+		free(chain);
+		memset(schema, 0, sizeof(struct ini_schema));
+
+		return ini_default_result(error);
+	}
+
+	if (!isChained)
+	{
+		free(chain);
+		chain = NULL;
+	}
+
+	schema->fields = fields;
+	schema->field_count = count;
+	schema->slots = slots;
+	schema->seed = seed;
+	schema->chain = chain;
+
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: free allocated memory of schema
+//-----------------------------------------------------------------------------
+
+void ini_schema_free(struct ini_schema *schema)
+{
+	free(schema->slots);
+	free(schema->chain);
+	memset(schema, 0, sizeof(struct ini_schema));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: set error of parsing
+//-----------------------------------------------------------------------------
+
+static int ini_parse_error(ini_parse_state_t *state, int error, const char *where)
+{
+	state->parser->error_code = error;
+	state->parser->line = state->line;
+	state->parser->column = (int)(where - state->lineStart) + 1;
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: set error of failed allocation, it has no position
+//-----------------------------------------------------------------------------
+
+static int ini_memory_error(struct ini_parser *parser)
+{
+	parser->error_code = INI_ERROR_OUT_OF_MEMORY;
+	parser->line = -1;
+	parser->column = -1;
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: save name of current section
+//-----------------------------------------------------------------------------
+
+static int ini_set_section(ini_parse_state_t *state, const char *section, size_t length)
+{
+	INI_STAT_ADD(sections, 1);
+
+	if (state->type == PARSE_DATA)
+	{
+		if (state->strings && !(section = ini_intern_string(state->strings, &state->data->arena, section, length)))
+			return ini_memory_error(state->parser);
+
+		state->section = ini_intern_section(state->data, section, length, state->reference || state->strings);
+
+		if (!state->section)
+			return ini_memory_error(state->parser);
+
+		return 1;
+	}
+
+	if (state->type == PARSE_PATCH)
+		return ini_patch_section(state, section, length);
+
+	if (!ini_reserve(&state->sectionBuffer, &state->sectionBufferSize, length + 1))
+		return ini_memory_error(state->parser);
+
+	memcpy(state->sectionBuffer, section, length);
+	state->sectionBuffer[length] = '\0';
+
+	if (state->type == PARSE_SCHEMA)
+	{
+		state->sectionLength = length;
+		state->sectionHash = ini_hash(section, length, 0);
+	}
+
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: save parameter in hash table or pass it to handler
+//-----------------------------------------------------------------------------
+
+static int ini_emit_parameter(ini_parse_state_t *state, const char *key, size_t keyLength, const char *value, size_t valueLength)
+{
+	INI_STAT_ADD(entries, 1);
+
+	if (state->type == PARSE_DATA)
+	{
+		struct ini_arena *arena = &state->data->arena;
+		struct ini_entry entry;
+
+		if (state->reference)
+		{
+			entry.key = key;
+			entry.value = value;
+		}
+		else
+		{
+			entry.key = state->strings ? ini_intern_string(state->strings, arena, key, keyLength) : ini_arena_strndup(arena, key, keyLength);
+			entry.value = ini_arena_strndup(arena, value, valueLength);
+
+			if (!entry.key || !entry.value)
+				return ini_memory_error(state->parser);
+		}
+
+		entry.section = state->section;
+		entry.key_length = keyLength;
+		entry.value_length = valueLength;
+		entry.hash = ini_hash(key, keyLength, state->section->hash);
+		entry.cache_state = INI_CACHE_EMPTY;
+		entry.cache = 0;
+
+		// Fill our hash table
+		if (!ini_add_entry(state->data, &entry))
+			return ini_memory_error(state->parser);
+	}
+	else if (state->type == PARSE_HANDLER)
+	{
+		if (!ini_reserve(&state->scratch, &state->scratchSize, keyLength + valueLength + 2))
+			return ini_memory_error(state->parser);
+
+		char *pszKey = state->scratch;
+		char *pszValue = state->scratch + keyLength + 1;
+
+		memcpy(pszKey, key, keyLength);
+		pszKey[keyLength] = '\0';
+
+		memcpy(pszValue, value, valueLength);
+		pszValue[valueLength] = '\0';
+
+		// Call our callback
+		state->handler(state->sectionBuffer, pszKey, pszValue);
+	}
+	else if (state->type == PARSE_SCHEMA)
+	{
+		const struct ini_schema_field *field = ini_schema_find(state->schema, state->sectionHash, state->sectionBuffer, state->sectionLength, key, keyLength);
+
+		// Unknown parameter
+		if (!field)
+			return 1;
+
+		int error = ini_store_field(state->object, field, value, valueLength);
+
+		if (error != INI_NO_ERROR)
+			return ini_parse_error(state, error, value);
+	}
+	else if (state->type == PARSE_PATCH)
+	{
+		return ini_patch_parameter(state, key, keyLength, value, valueLength);
+	}
+
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: parse classified line
+//-----------------------------------------------------------------------------
+
+static int ini_parse_scanned_line(ini_parse_state_t *state, const ini_line_t *line)
+{
+	const char *str = line->begin;
+	const char *end = line->end;
+
+	++state->line;
+	state->lineStart = line->start;
+	state->lineNext = line->next;
+
+	INI_STAT_ADD(lines, 1);
+	INI_STAT_ADD(bytes, line->next - line->start);
+
+	// Nothing here, skip
+	if (str == end)
+		return 1;
+
+	// Found prefix of section, start parsing a new one
+	if (*str == INI_SECTION_PREFIX)
+		state->parsingSection = 1;
+
+	// Parsing section
+	if (state->parsingSection)
+	{
+		if (*str != INI_SECTION_PREFIX)
+			return ini_parse_error(state, INI_ERROR_SECTION_START_ID, str);
+
+		// Exclude prefix of section
+		++str;
+
+		if (str == end || *(end - 1) != INI_SECTION_POSTFIX)
+			return ini_parse_error(state, INI_ERROR_SECTION_END_ID, end);
+
+		// Exclude postfix of section and strip
+		const char *prefix = str - 1;
+
+		str = ini_lstrip(str, end - 1);
+		end = ini_rstrip(str, end - 1);
+
+		if (str == end)
+			return ini_parse_error(state, INI_ERROR_SECTION_EMPTY, prefix);
+
+		// Next try to parse parameters
+		state->parsingSection = 0;
+
+		// Save name of section
+		return ini_set_section(state, str, end - str);
+	}
+
+	const char *keyEnd = line->delimiter ? line->delimiter : end;
+
+	// Split parameter, repeated delimiters are skipped
+	if (keyEnd == str)
+	{
+		while (str < end && *str == INI_PARAMETER_DELIMITER_CHAR)
+			++str;
+
+		if (str == end)
+			return ini_parse_error(state, INI_ERROR_KEY_EMPTY, str);
+
+		keyEnd = ini_find_delimiter(str, end);
+	}
+
+	const char *key = str;
+	const char *value = keyEnd;
+
+	while (value < end && *value == INI_PARAMETER_DELIMITER_CHAR)
+		++value;
+
+	if (value == end)
+		return ini_parse_error(state, INI_ERROR_VALUE_EMPTY, value);
+
+	const char *valueEnd = ini_find_delimiter(value, end);
+
+	// Strip
+	keyEnd = ini_rstrip(key, keyEnd);
+	value = ini_lstrip(value, valueEnd);
+	valueEnd = ini_rstrip(value, valueEnd);
+
+	return ini_emit_parameter(state, key, keyEnd - key, value, valueEnd - value);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: parse a single line of text
+//-----------------------------------------------------------------------------
+
+static int ini_parse_line(ini_parse_state_t *state, const char *str, size_t length)
+{
+	ini_line_t line;
+	ini_scan_line(str, str + length, &line);
+
+	return ini_parse_scanned_line(state, &line);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: parse text in memory line by line
+//-----------------------------------------------------------------------------
+
+static int ini_parse_text(ini_parse_state_t *state, const char *text, size_t length)
+{
+	const char *end = text + length;
+	ini_line_t line;
+
+	while (text < end)
+	{
+		ini_scan_line(text, end, &line);
+
+		if (!ini_parse_scanned_line(state, &line))
+			return 0;
+
+		text = line.next;
+	}
+
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: prepare state of parsing
+//-----------------------------------------------------------------------------
+
+static void ini_init_state(ini_parse_state_t *state, struct ini_parser *parser, parse_type_t type, struct ini_data *data, iniHandlerFn handler, const struct ini_schema *schema, void *object)
+{
+	memset(state, 0, sizeof(ini_parse_state_t));
+
+	state->parser = parser;
+	state->type = type;
+	state->data = data;
+	state->handler = handler;
+	state->schema = schema;
+	state->object = (char *)object;
+	state->parsingSection = 1;
+
+	// Error of previous parsing isn't left for failure which sets no error
+	parser->error_code = INI_NO_ERROR;
+	parser->line = -1;
+	parser->column = -1;
+
+#ifdef INI_STATS
+	if (parser->stats)
+		memset(parser->stats, 0, sizeof(struct ini_stats));
+
+	state->previousStats = s_stats;
+	state->startTime = ini_clock();
+
+	s_stats = parser->stats;
+#endif
+
+	// Zero memory
+	if (type == PARSE_DATA)
+	{
+		memset(data, 0, sizeof(struct ini_data));
+		data->generation = ini_next_generation();
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: release memory of state
+//-----------------------------------------------------------------------------
+
+static int ini_finish_state(ini_parse_state_t *state, int success)
+{
+	if (state->sectionBuffer)
+		free(state->sectionBuffer);
+
+	if (state->scratch)
+		free(state->scratch);
+
+	// Entries of each section become contiguous
+	if (success && state->type == PARSE_DATA && !ini_index_sections(state->data, 1))
+		success = ini_memory_error(state->parser);
+
+	INI_STAT_CLOCK(convertStart);
+	INI_STAT_ADD(parse_time, convertStart - state->startTime);
+
+	// Convert declared parameters once
+	if (success && state->type == PARSE_DATA && state->parser->types)
+	{
+		int error = ini_convert_entries(state->data, state->parser->types, state->parser->type_count);
+
+		INI_STAT_ADD(convert_time, ini_clock() - convertStart);
+
+		if (error != INI_NO_ERROR)
+		{
+			state->parser->error_code = error;
+			state->parser->line = -1;
+			state->parser->column = -1;
+
+			success = 0;
+		}
+	}
+
+	// Every failure without its own error is failed allocation
+	if (!success && state->parser->error_code == INI_NO_ERROR)
+		ini_memory_error(state->parser);
+
+	// Don't leave partially filled hash table
+	if (!success && state->type == PARSE_DATA)
+		ini_free_data(state->data, 0);
+
+	if (success)
+	{
+		state->parser->error_code = INI_NO_ERROR;
+		state->parser->line = -1;
+		state->parser->column = -1;
+	}
+
+#ifdef INI_STATS
+	s_stats = state->previousStats;
+#endif
+
+	return success;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: get last error message
+//-----------------------------------------------------------------------------
+
+const char *ini_get_last_error_msg()
+{
+	return ini_parser_get_error_msg(&s_default_parser);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: get last error code
+//-----------------------------------------------------------------------------
+
+int ini_get_last_error()
+{
+	return s_default_parser.error_code;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: get last line where an error has occurred
+//-----------------------------------------------------------------------------
+
+int ini_get_last_line()
+{
+	return s_default_parser.line;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: get last column where an error has occurred
+//-----------------------------------------------------------------------------
+
+int ini_get_last_column()
+{
+	return s_default_parser.column;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: get value of digit of any radix up to 36 (255 - not a digit)
+//-----------------------------------------------------------------------------
+
+static unsigned int ini_digit_value(char ch)
+{
+	if (ch >= '0' && ch <= '9')
+		return (unsigned int)(ch - '0');
+
+	if (ch >= 'a' && ch <= 'z')
+		return (unsigned int)(ch - 'a') + 10;
+
+	if (ch >= 'A' && ch <= 'Z')
+		return (unsigned int)(ch - 'A') + 10;
+
+	return 255;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: compare string with lowercase word ignoring case of letters
+//-----------------------------------------------------------------------------
+
+static int ini_equal_nocase(const char *str, const char *end, const char *word)
+{
+	for (; str < end && *word; ++str, ++word)
+	{
+		char ch = *str;
+
+		if (ch >= 'A' && ch <= 'Z')
+			ch = (char)(ch - 'A' + 'a');
+
+		if (ch != *word)
+			return 0;
+	}
+
+	return str == end && !*word;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: convert digits to unsigned number not greater than maximum
+//-----------------------------------------------------------------------------
+
+static int ini_to_unsigned(const char *str, const char *end, unsigned int radix, unsigned long long max, unsigned long long *result)
+{
+	const unsigned long long limit = max / radix;
+	const unsigned int limitDigit = (unsigned int)(max % radix);
+
+	unsigned long long value = 0;
+	int isOverflow = 0;
+
+	if (str == end)
+		return INI_ERROR_INVALID_VALUE;
+
+	for (; str < end; ++str)
+	{
+		const unsigned int digit = ini_digit_value(*str);
+
+		if (digit >= radix)
+			return INI_ERROR_INVALID_VALUE;
+
+		// Keep checking the rest for garbage
+		if (value > limit || (value == limit && digit > limitDigit))
+			isOverflow = 1;
+		else
+			value = value * radix + digit;
+	}
+
+	if (isOverflow)
+		return INI_ERROR_OUT_OF_RANGE;
+
+	*result = value;
+	return INI_NO_ERROR;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: convert decimal signed integer within the given range
+//-----------------------------------------------------------------------------
+
+static int ini_to_integer(const char *str, const char *end, long long min, long long max, long long *result)
+{
+	int isNegative = 0;
+
+	if (str < end && (*str == '+' || *str == '-'))
+		isNegative = (*str++ == '-');
+
+	// Magnitude of minimum can't be negated in signed type
+	unsigned long long magnitude;
+	unsigned long long limit = isNegative ? (unsigned long long)(-(min + 1)) + 1 : (unsigned long long)max;
+
+	int error = ini_to_unsigned(str, end, 10, limit, &magnitude);
+
+	if (error != INI_NO_ERROR)
+		return error;
+
+	if (!isNegative)
+		*result = (long long)magnitude;
+	else if (magnitude)
+		*result = -(long long)(magnitude - 1) - 1;
+	else
+		*result = 0;
+
+	return INI_NO_ERROR;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: convert unsigned integer, radix 0 detects prefixes 0x and 0
+//-----------------------------------------------------------------------------
+
+static int ini_to_radix(const char *str, const char *end, int radix, unsigned long long max, unsigned long long *result)
+{
+	int isNegative = 0;
+
+	if (str < end && (*str == '+' || *str == '-'))
+		isNegative = (*str++ == '-');
+
+	int hasHexPrefix = (end - str > 2 && str[0] == '0' && (str[1] == 'x' || str[1] == 'X'));
+
+	if (radix == 0)
+	{
+		if (hasHexPrefix)
+			radix = 16;
+		else if (end - str > 1 && str[0] == '0')
+			radix = 8;
+		else
+			radix = 10;
+	}
+
+	if (radix < 2 || radix > 36)
+		return INI_ERROR_INVALID_VALUE;
+
+	if (radix == 16 && hasHexPrefix)
+		str += 2;
+
+	int error = ini_to_unsigned(str, end, (unsigned int)radix, max, result);
+
+	// Only zero can be negative
+	if (error == INI_NO_ERROR && isNegative && *result != 0)
+		return INI_ERROR_OUT_OF_RANGE;
+
+	return error;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: multiply big integer by small number and add another one
+//-----------------------------------------------------------------------------
+
+static void ini_big_mul_add(ini_big_t *big, unsigned int multiplier, unsigned int addend)
+{
+	unsigned long long carry = addend;
+
+	for (size_t i = 0; i < big->count; ++i)
+	{
+		carry += (unsigned long long)big->words[i] * multiplier;
+		big->words[i] = (unsigned int)carry;
+		carry >>= 32;
+	}
+
+	if (carry && big->count < INI_BIG_WORDS)
+		big->words[big->count++] = (unsigned int)carry;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: multiply big integer by 64-bit number
+//-----------------------------------------------------------------------------
+
+static void ini_big_mul_u64(ini_big_t *big, unsigned long long multiplier)
+{
+	unsigned long long low = multiplier & 0xFFFFFFFFu;
+	unsigned long long high = multiplier >> 32;
+	unsigned long long carry = 0;
+
+	for (size_t i = 0; i < big->count; ++i)
+	{
+		unsigned long long word = big->words[i];
+		unsigned long long product = word * low + (carry & 0xFFFFFFFFu);
+
+		big->words[i] = (unsigned int)product;
+		carry = (carry >> 32) + (product >> 32) + word * high;
+	}
+
+	for (; carry && big->count < INI_BIG_WORDS; carry >>= 32)
+		big->words[big->count++] = (unsigned int)carry;
+
+	while (big->count && !big->words[big->count - 1])
+		--big->count;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: multiply big integer by power of ten
+//-----------------------------------------------------------------------------
+
+static void ini_big_mul_pow10(ini_big_t *big, int exponent)
+{
+	static const unsigned int powersOfTen[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 };
+
+	for (; exponent >= 9; exponent -= 9)
+		ini_big_mul_add(big, 1000000000u, 0);
+
+	if (exponent > 0)
+		ini_big_mul_add(big, powersOfTen[exponent], 0);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: shift big integer left by any number of bits
+//-----------------------------------------------------------------------------
+
+static void ini_big_shift_left(ini_big_t *big, int bits)
+{
+	size_t words = (size_t)bits / 32;
+	int shift = bits % 32;
+
+	if (!big->count || big->count + words + 1 > INI_BIG_WORDS)
+		return;
+
+	big->words[big->count] = 0;
+
+	for (size_t i = big->count + 1; i-- > 0;)
+	{
+		unsigned int word = big->words[i] << shift;
+
+		if (shift && i > 0)
+			word |= big->words[i - 1] >> (32 - shift);
+
+		big->words[i + words] = word;
+	}
+
+	memset(big->words, 0, words * sizeof(unsigned int));
+
+	big->count += words + 1;
+
+	while (big->count && !big->words[big->count - 1])
+		--big->count;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: shift big integer right by one bit
+//-----------------------------------------------------------------------------
+
+static void ini_big_shift_right(ini_big_t *big)
+{
+	for (size_t i = 0; i < big->count; ++i)
+		big->words[i] = (big->words[i] >> 1) | ((i + 1 < big->count) ? big->words[i + 1] << 31 : 0);
+
+	if (big->count && !big->words[big->count - 1])
+		--big->count;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: compare big integers
+// Return value: negative, zero or positive number as of memcmp
+//-----------------------------------------------------------------------------
+
+static int ini_big_compare(const ini_big_t *a, const ini_big_t *b)
+{
+	if (a->count != b->count)
+		return (a->count < b->count) ? -1 : 1;
+
+	for (size_t i = a->count; i-- > 0;)
+	{
+		if (a->words[i] != b->words[i])
+			return (a->words[i] < b->words[i]) ? -1 : 1;
+	}
+
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: subtract big integer which isn't greater than the other one
+//-----------------------------------------------------------------------------
+
+static void ini_big_subtract(ini_big_t *a, const ini_big_t *b)
+{
+	unsigned long long borrow = 0;
+
+	for (size_t i = 0; i < a->count; ++i)
+	{
+		unsigned long long word = (unsigned long long)a->words[i] - ((i < b->count) ? b->words[i] : 0) - borrow;
+
+		a->words[i] = (unsigned int)word;
+		borrow = (word >> 32) & 1;
+	}
+
+	while (a->count && !a->words[a->count - 1])
+		--a->count;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: get number of significant bits of big integer
+//-----------------------------------------------------------------------------
+
+static int ini_big_bits(const ini_big_t *big)
+{
+	if (!big->count)
+		return 0;
+
+	unsigned int top = big->words[big->count - 1];
+	int bits = (int)(big->count - 1) * 32;
+
+	for (; top; top >>= 1)
+		++bits;
+
+	return bits;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: get big integer shifted right by the given number of bits, so that
+// only its highest 64 bits are left
+//-----------------------------------------------------------------------------
+
+static unsigned long long ini_big_top(const ini_big_t *big, int shift)
+{
+	if (shift <= 0)
+	{
+		unsigned long long value = 0;
+
+		for (size_t i = big->count; i-- > 0;)
+			value = (value << 32) | big->words[i];
+
+		return value;
+	}
+
+	size_t word = (size_t)shift / 32;
+	unsigned long long value = big->words[word] | ((unsigned long long)big->words[word + 1] << 32);
+
+	if (shift % 32)
+		value = (value >> (shift % 32)) | ((unsigned long long)big->words[word + 2] << (64 - shift % 32));
+
+	return value;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: convert floating point number independently of locale with exact
+// arithmetic of big integers, result is correctly rounded (to nearest, ties
+// to even). Used when mantissa or power of ten isn't exactly representable
+//-----------------------------------------------------------------------------
+
+static int ini_to_real_slow(const char *str, const char *end, int isFloat, double *result)
+{
+	// Precision and exponent of the least significant bit of subnormal numbers
+	const int precision = isFloat ? FLT_MANT_DIG : DBL_MANT_DIG;
+	const int minExponent = isFloat ? FLT_MIN_EXP - FLT_MANT_DIG : DBL_MIN_EXP - DBL_MANT_DIG;
+	const int maxExponent = isFloat ? FLT_MAX_EXP : DBL_MAX_EXP;
+
+	int isNegative = 0;
+
+	if (str < end && (*str == '+' || *str == '-'))
+		isNegative = (*str++ == '-');
+
+	ini_big_t numerator, denominator;
+
+	numerator.count = 0;
+
+	// Digits are added in groups of nine
+	unsigned int group = 0;
+	unsigned int groupScale = 1;
+
+	int digits = 0;
+	long exponent = 0;
+	int isTruncated = 0;
+
+	for (int isFraction = 0; str < end; ++str)
+	{
+		if (*str == '.')
+		{
+			isFraction = 1;
+			continue;
+		}
+
+		if (*str < '0' || *str > '9')
+			break;
+
+		// Leading zeros
+		if (!digits && *str == '0')
+		{
+			exponent -= isFraction;
+			continue;
+		}
+
+		if (digits >= INI_REAL_DIGITS)
+		{
+			exponent += !isFraction;
+			isTruncated |= (*str != '0');
+			continue;
+		}
+
+		exponent -= isFraction;
+
+		group = group * 10 + (unsigned int)(*str - '0');
+		groupScale *= 10;
+		++digits;
+
+		if (groupScale == 1000000000u)
+		{
+			ini_big_mul_add(&numerator, groupScale, group);
+			group = 0;
+			groupScale = 1;
+		}
+	}
+
+	if (groupScale > 1)
+		ini_big_mul_add(&numerator, groupScale, group);
+
+	// Dropped digits only decide halfway cases, any non-zero one is above half
+	if (isTruncated)
+	{
+		ini_big_mul_add(&numerator, 10, 1);
+		++digits;
+		--exponent;
+	}
+
+	if (str < end && (*str == 'e' || *str == 'E'))
+	{
+		int isNegativeExponent = 0;
+		long explicitExponent = 0;
+
+		++str;
+
+		if (str < end && (*str == '+' || *str == '-'))
+			isNegativeExponent = (*str++ == '-');
+
+		for (; str < end && *str >= '0' && *str <= '9'; ++str)
+		{
+			if (explicitExponent < 100000)
+				explicitExponent = explicitExponent * 10 + (*str - '0');
+		}
+
+		exponent += isNegativeExponent ? -explicitExponent : explicitExponent;
+	}
+
+	// Value is at least 10^(digits + exponent - 1) and less than 10^(digits + exponent)
+	if (!digits || digits + exponent < DBL_MIN_10_EXP - DBL_DIG - 1)
+	{
+		*result = isNegative ? -0.0 : 0.0;
+		return INI_NO_ERROR;
+	}
+
+	if (digits + exponent - 1 > DBL_MAX_10_EXP)
+	{
+		*result = isNegative ? -HUGE_VAL : HUGE_VAL;
+		return INI_ERROR_OUT_OF_RANGE;
+	}
+
+	// Value is numerator / denominator
+	denominator.words[0] = 1;
+	denominator.count = 1;
+
+	if (exponent > 0)
+		ini_big_mul_pow10(&numerator, (int)exponent);
+	else
+		ini_big_mul_pow10(&denominator, (int)-exponent);
+
+	// Quotient of numerator / (denominator * 2^binaryExponent) gets precision or one more bits
+	int binaryExponent = ini_big_bits(&numerator) - ini_big_bits(&denominator) - precision;
+
+	if (binaryExponent < minExponent)
+		binaryExponent = minExponent;
+
+	if (binaryExponent > 0)
+		ini_big_shift_left(&denominator, binaryExponent);
+	else
+		ini_big_shift_left(&numerator, -binaryExponent);
+
+	// Quotient is estimated from leading bits in floating point with error of a few units, its
+	// lower bound is subtracted exactly and the rest (less than 64) is divided bit by bit
+	int numeratorShift = ini_big_bits(&numerator) - 64;
+	int denominatorShift = ini_big_bits(&denominator) - 64;
+
+	double estimate = (double)ini_big_top(&numerator, numeratorShift) / (double)ini_big_top(&denominator, denominatorShift);
+	estimate = ldexp(estimate, (numeratorShift > 0 ? numeratorShift : 0) - (denominatorShift > 0 ? denominatorShift : 0));
+	unsigned long long quotient = (estimate > 16.0) ? (unsigned long long)estimate - 16 : 0;
+
+	ini_big_t product = denominator;
+
+	ini_big_mul_u64(&product, quotient);
+	ini_big_subtract(&numerator, &product);
+
+	ini_big_shift_left(&denominator, 5);
+
+	for (int i = 0; i < 6; ++i)
+	{
+		if (ini_big_compare(&numerator, &denominator) >= 0)
+		{
+			ini_big_subtract(&numerator, &denominator);
+			quotient += 32ULL >> i;
+		}
+
+		if (i < 5)
+			ini_big_shift_right(&denominator);
+	}
+
+	// Remainder decides rounding, compared with half of divisor
+	int isAboveHalf, isHalf;
+
+	if (quotient >> precision)
+	{
+		isHalf = (quotient & 1) && !numerator.count;
+		isAboveHalf = (quotient & 1) && numerator.count;
+
+		quotient >>= 1;
+		++binaryExponent;
+	}
+	else
+	{
+		ini_big_shift_left(&numerator, 1);
+
+		int comparison = ini_big_compare(&numerator, &denominator);
+
+		isHalf = (comparison == 0);
+		isAboveHalf = (comparison > 0);
+	}
+
+	if (isAboveHalf || (isHalf && (quotient & 1)))
+	{
+		if (++quotient >> precision)
+		{
+			quotient >>= 1;
+			++binaryExponent;
+		}
+	}
+
+	if (binaryExponent + precision > maxExponent)
+	{
+		*result = isNegative ? -HUGE_VAL : HUGE_VAL;
+		return INI_ERROR_OUT_OF_RANGE;
+	}
+
+	// Exact, quotient and result are representable
+	double value = ldexp((double)quotient, binaryExponent);
+
+	*result = isNegative ? -value : value;
+	return INI_NO_ERROR;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: convert floating point number independently of locale, exactly
+// representable mantissa and power of ten are multiplied directly
+//-----------------------------------------------------------------------------
+
+static int ini_to_real(const char *str, const char *end, int isFloat, double *result)
+{
+	static const double powersOfTen[] =
+	{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	const char *start = str;
+	int isNegative = 0;
+
+	if (str < end && (*str == '+' || *str == '-'))
+		isNegative = (*str++ == '-');
+
+	if (ini_equal_nocase(str, end, "inf") || ini_equal_nocase(str, end, "infinity"))
+	{
+		*result = isNegative ? -HUGE_VAL : HUGE_VAL;
+		return INI_NO_ERROR;
+	}
+
+	if (ini_equal_nocase(str, end, "nan"))
+	{
+		*result = isNegative ? -NAN : NAN;
+		return INI_NO_ERROR;
+	}
+
+	unsigned long long mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	int hasDigits = 0;
+	int isTruncated = 0;
+
+	// Up to 19 significant digits fit in mantissa
+	for (; str < end && *str >= '0' && *str <= '9'; ++str, hasDigits = 1)
+	{
+		if (mantissa == 0 && *str == '0')
+			continue;
+
+		if (digits < 19)
+		{
+			mantissa = mantissa * 10 + (unsigned int)(*str - '0');
+			++digits;
+		}
+		else
+		{
+			++exponent;
+			isTruncated |= (*str != '0');
+		}
+	}
+
+	if (str < end && *str == '.')
+	{
+		for (++str; str < end && *str >= '0' && *str <= '9'; ++str, hasDigits = 1)
+		{
+			if (mantissa == 0 && *str == '0')
+			{
+				--exponent;
+			}
+			else if (digits < 19)
+			{
+				mantissa = mantissa * 10 + (unsigned int)(*str - '0');
+				++digits;
+				--exponent;
+			}
+			else
+			{
+				isTruncated |= (*str != '0');
+			}
+		}
+	}
+
+	if (!hasDigits)
+		return INI_ERROR_INVALID_VALUE;
+
+	if (str < end && (*str == 'e' || *str == 'E'))
+	{
+		int isNegativeExponent = 0;
+		int explicitExponent = 0;
+
+		++str;
+
+		if (str < end && (*str == '+' || *str == '-'))
+			isNegativeExponent = (*str++ == '-');
+
+		if (str == end || *str < '0' || *str > '9')
+			return INI_ERROR_INVALID_VALUE;
+
+		for (; str < end && *str >= '0' && *str <= '9'; ++str)
+		{
+			if (explicitExponent < 100000)
+				explicitExponent = explicitExponent * 10 + (*str - '0');
+		}
+
+		exponent += isNegativeExponent ? -explicitExponent : explicitExponent;
+	}
+
+	if (str != end)
+		return INI_ERROR_INVALID_VALUE;
+
+	if (mantissa == 0)
+	{
+		*result = isNegative ? -0.0 : 0.0;
+		return INI_NO_ERROR;
+	}
+
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+	// Both operands are exact, so the only rounding is the one of division or multiplication
+	if (!isTruncated)
+	{
+		if (isFloat && mantissa <= (1ULL << 24) && exponent >= -10 && exponent <= 10)
+		{
+			float value = (float)mantissa;
+			value = (exponent < 0) ? value / (float)powersOfTen[-exponent] : value * (float)powersOfTen[exponent];
+
+			*result = isNegative ? -value : value;
+			return INI_NO_ERROR;
+		}
+
+		if (!isFloat && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22)
+		{
+			double value = (double)mantissa;
+			value = (exponent < 0) ? value / powersOfTen[-exponent] : value * powersOfTen[exponent];
+
+			*result = isNegative ? -value : value;
+			return INI_NO_ERROR;
+		}
+	}
+#else
+	(void)powersOfTen;
+	(void)isTruncated;
+#endif
+
+	return ini_to_real_slow(start, end, isFloat, result);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: convert boolean word or 1 / 0
+//-----------------------------------------------------------------------------
+
+static int ini_to_bool(const char *str, const char *end, int *result)
+{
+	static const char *trueWords[] = { "1", "true", "yes", "on" };
+	static const char *falseWords[] = { "0", "false", "no", "off" };
+
+	for (size_t i = 0; i < sizeof(trueWords) / sizeof(trueWords[0]); ++i)
+	{
+		if (ini_equal_nocase(str, end, trueWords[i]))
+		{
+			*result = 1;
+			return INI_NO_ERROR;
+		}
+
+		if (ini_equal_nocase(str, end, falseWords[i]))
+		{
+			*result = 0;
+			return INI_NO_ERROR;
+		}
+	}
+
+	return INI_ERROR_INVALID_VALUE;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: convert value of known length to field type
+//
+// Return value: INI_NO_ERROR or error code of conversion
+//-----------------------------------------------------------------------------
+
+static int ini_convert(const char *value, size_t length, struct ini_datatype *datatype, int fieldtype)
+{
+	const char *str = ini_lstrip(value, value + length);
+	const char *end = ini_rstrip(str, value + length);
+
+	long long integer;
+	unsigned long long number;
+	double real;
+	int boolean;
+
+	int error;
+
+	switch (fieldtype != -1 ? fieldtype : (int)datatype->fieldtype)
+	{
+	case INI_FIELD_INTEGER:
+		if ((error = ini_to_integer(str, end, INT_MIN, INT_MAX, &integer)) == INI_NO_ERROR)
+			datatype->m_int = (int)integer;
+		break;
+
+	case INI_FIELD_INT64:
+		if ((error = ini_to_integer(str, end, LLONG_MIN, LLONG_MAX, &integer)) == INI_NO_ERROR)
+			datatype->m_int64 = integer;
+		break;
+
+	case INI_FIELD_FLOAT:
+		if ((error = ini_to_real(str, end, 1, &real)) == INI_NO_ERROR)
+		{
+			if (real > FLT_MAX || real < -FLT_MAX)
+			{
+				// Infinity written explicitly is fine
+				if (real != HUGE_VAL && real != -HUGE_VAL)
+					error = INI_ERROR_OUT_OF_RANGE;
+			}
+
+			datatype->m_float = (float)real;
+		}
+		break;
+
+	case INI_FIELD_DOUBLE:
+		if ((error = ini_to_real(str, end, 0, &real)) == INI_NO_ERROR)
+			datatype->m_double = real;
+		break;
+
+	case INI_FIELD_BYTE:
+		if ((error = ini_to_integer(str, end, 0, UCHAR_MAX, &integer)) == INI_NO_ERROR)
+			datatype->m_byte = (unsigned char)integer;
+		break;
+
+	case INI_FIELD_CHAR:
+		if ((error = ini_to_integer(str, end, CHAR_MIN, CHAR_MAX, &integer)) == INI_NO_ERROR)
+			datatype->m_char = (char)integer;
+		break;
+
+	case INI_FIELD_CSTRING:
+	{
+		char *copy = malloc(length + 1);
+
+		if (!copy)
+			return INI_ERROR_OUT_OF_MEMORY;
+
+		memcpy(copy, value, length);
+		copy[length] = '\0';
+
+		datatype->m_pszString = copy;
+		error = INI_NO_ERROR;
+		break;
+	}
+
+	case INI_FIELD_UINT32:
+		if ((error = ini_to_radix(str, end, datatype->radix, UINT_MAX, &number)) == INI_NO_ERROR)
+			datatype->m_uint32 = (unsigned int)number;
+		break;
+
+	case INI_FIELD_UINT64:
+		if ((error = ini_to_radix(str, end, datatype->radix, ULLONG_MAX, &number)) == INI_NO_ERROR)
+			datatype->m_uint64 = number;
+		break;
+
+	case INI_FIELD_BOOL:
+		if ((error = ini_to_bool(str, end, &boolean)) == INI_NO_ERROR)
+			datatype->m_bool = boolean ? 1 : 0;
+		break;
+
+	case INI_FIELD_STRING_VIEW:
+		datatype->m_view.string = value;
+		datatype->m_view.length = length;
+		error = INI_NO_ERROR;
+		break;
+
+	default:
+		return INI_ERROR_INVALID_FIELD_TYPE;
+	}
+
+	return error;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: report result of call through default context
+//-----------------------------------------------------------------------------
+
+static int ini_default_result(int error)
+{
+	if (error == INI_NO_ERROR)
+		return 1;
+
+	s_default_parser.error_code = error;
+	s_default_parser.line = -1;
+	s_default_parser.column = -1;
+
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: collect statistics of parsing of default context
+//-----------------------------------------------------------------------------
+
+int ini_set_stats(struct ini_stats *stats)
+{
+	return ini_parser_set_stats(&s_default_parser, stats);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: read data from string
+//-----------------------------------------------------------------------------
+
+int ini_read_string(const char *value, struct ini_datatype *datatype, int fieldtype)
+{
+	return ini_default_result(ini_convert(value, strlen(value), datatype, fieldtype));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: find entry by names of section and key
+//-----------------------------------------------------------------------------
+
+static struct ini_entry *ini_lookup(const struct ini_data *data, const char *section, const char *key)
+{
+	size_t sectionLength = strlen(section);
+	const struct ini_section *sect = ini_find_section(data, section, sectionLength, ini_hash(section, sectionLength, 0));
+
+	if (!sect || (data->lazy && !ini_load_section((struct ini_data *)data, sect)))
+		return NULL;
+
+	size_t keyLength = strlen(key);
+	return ini_find_entry(data, sect, key, keyLength, ini_hash(key, keyLength, sect->hash));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: get state of cache for field type, 0 - type can't be cached
+//-----------------------------------------------------------------------------
+
+static unsigned int ini_cache_state(int fieldtype, int radix)
+{
+	switch (fieldtype)
+	{
+	case INI_FIELD_INTEGER:
+	case INI_FIELD_INT64:
+	case INI_FIELD_FLOAT:
+	case INI_FIELD_DOUBLE:
+	case INI_FIELD_BYTE:
+	case INI_FIELD_CHAR:
+	case INI_FIELD_BOOL:
+		return INI_CACHE_READY | ((unsigned int)fieldtype << 8);
+
+	case INI_FIELD_UINT32:
+	case INI_FIELD_UINT64:
+		return INI_CACHE_READY | ((unsigned int)fieldtype << 8) | (unsigned int)(radix & 0xFF);
+
+	default:
+		return INI_CACHE_EMPTY;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: read data from entry of hash table, remember converted value
+//
+// Return value: INI_NO_ERROR or error code of conversion
+//-----------------------------------------------------------------------------
+
+static int ini_read_entry(struct ini_entry *entry, struct ini_datatype *datatype, int fieldtype)
+{
+	int type = (fieldtype != -1) ? fieldtype : (int)datatype->fieldtype;
+	unsigned int cacheState = ini_cache_state(type, datatype->radix);
+
+	unsigned int state = INI_ATOMIC_LOAD_ACQUIRE(&entry->cache_state);
+
+	// Converted already, plain load
+	if (cacheState != INI_CACHE_EMPTY && state == cacheState)
+	{
+		memcpy(&datatype->m_uint64, &entry->cache, sizeof(entry->cache));
+		return INI_NO_ERROR;
+	}
+
+	int error = ini_convert(entry->value, entry->value_length, datatype, fieldtype);
+
+	if (error != INI_NO_ERROR)
+		return error;
+
+	// The first type read wins, one thread writes cache and then publishes it
+	if (cacheState != INI_CACHE_EMPTY && state == INI_CACHE_EMPTY && INI_ATOMIC_CAS(&entry->cache_state, INI_CACHE_EMPTY, INI_CACHE_BUSY))
+	{
+		memcpy(&entry->cache, &datatype->m_uint64, sizeof(entry->cache));
+		INI_ATOMIC_STORE_RELEASE(&entry->cache_state, cacheState);
+	}
+
+	return INI_NO_ERROR;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: read data from filled hash table
+//-----------------------------------------------------------------------------
+
+int ini_read_data(struct ini_data *data, const char *section, const char *key, struct ini_datatype *datatype, int fieldtype)
+{
+	struct ini_entry *entry = ini_lookup(data, section, key);
+
+	if (!entry)
+		return 0;
+
+	return ini_default_result(ini_read_entry(entry, datatype, fieldtype));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: resolve block of queries, each step of all queries is done before
+// the next one so that their loads are in flight together
+//-----------------------------------------------------------------------------
+
+static size_t ini_read_batch(struct ini_data *data, struct ini_query *queries, size_t count)
+{
+	const struct ini_section *sections[INI_BATCH_SIZE];
+	struct ini_entry *entries[INI_BATCH_SIZE];
+	unsigned int hashes[INI_BATCH_SIZE];
+	size_t keyLengths[INI_BATCH_SIZE];
+	size_t slots[INI_BATCH_SIZE];
+
+	const size_t mask = data->slot_count - 1;
+
+	// Hash names, queries usually come grouped by sections
+	const char *previousName = NULL;
+	const struct ini_section *previousSection = NULL;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const char *name = queries[i].section;
+
+		if (!previousName || (name != previousName && strcmp(name, previousName)))
+		{
+			size_t length = strlen(name);
+
+			previousName = name;
+			previousSection = ini_find_section(data, name, length, ini_hash(name, length, 0));
+
+			if (previousSection && data->lazy && !ini_load_section(data, previousSection))
+				previousSection = NULL;
+		}
+
+		sections[i] = previousSection;
+		entries[i] = NULL;
+
+		if (!sections[i] || !data->slots)
+			continue;
+
+		keyLengths[i] = strlen(queries[i].key);
+		hashes[i] = ini_hash(queries[i].key, keyLengths[i], sections[i]->hash);
+		slots[i] = hashes[i] & mask;
+
+		INI_PREFETCH(&data->slots[slots[i]]);
+	}
+
+	// Find slots with the same hash
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (!sections[i] || !data->slots)
+			continue;
+
+		size_t j = slots[i];
+		unsigned int index;
+
+		while ((index = INI_ATOMIC_LOAD_ACQUIRE(&data->slots[j].index)) && data->slots[j].hash != hashes[i])
+			j = (j + 1) & mask;
+
+		if (index)
+		{
+			entries[i] = &data->entries[index - 1];
+			INI_PREFETCH(entries[i]);
+		}
+	}
+
+	// Compare names, different names with the same hash are found by full probing
+	for (size_t i = 0; i < count; ++i)
+	{
+		struct ini_entry *entry = entries[i];
+
+		if (!entry)
+			continue;
+
+		if (entry->section != sections[i] || entry->key_length != keyLengths[i] || memcmp(entry->key, queries[i].key, keyLengths[i]))
+			entry = entries[i] = ini_find_entry(data, sections[i], queries[i].key, keyLengths[i], hashes[i]);
+
+		if (entry)
+			INI_PREFETCH(entry->value);
+	}
+
+	// Convert values grouped by types
+	unsigned char order[INI_BATCH_SIZE];
+	size_t starts[INI_FIELD_STRING_VIEW + 3] = { 0 };
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		int type = (int)queries[i].datatype.fieldtype;
+		++starts[(type >= 0 && type <= INI_FIELD_STRING_VIEW) ? type + 2 : 1];
+	}
+
+	for (size_t i = 2; i < INI_FIELD_STRING_VIEW + 3; ++i)
+		starts[i] += starts[i - 1];
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		int type = (int)queries[i].datatype.fieldtype;
+		order[starts[(type >= 0 && type <= INI_FIELD_STRING_VIEW) ? type + 1 : 0]++] = (unsigned char)i;
+	}
+
+	size_t found = 0;
+
+	for (size_t n = 0; n < count; ++n)
+	{
+		struct ini_query *query = &queries[order[n]];
+		struct ini_entry *entry = entries[order[n]];
+
+		query->error_code = entry ? ini_read_entry(entry, &query->datatype, -1) : INI_ERROR_MISSING_PARAMETER;
+
+		if (query->error_code == INI_NO_ERROR)
+			++found;
+	}
+
+	return found;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: read many parameters from filled hash table in one pass
+//-----------------------------------------------------------------------------
+
+size_t ini_read_many(struct ini_data *data, struct ini_query *queries, size_t count)
+{
+	size_t found = 0;
+
+	for (size_t i = 0; i < count; i += INI_BATCH_SIZE)
+		found += ini_read_batch(data, queries + i, (count - i < INI_BATCH_SIZE) ? count - i : INI_BATCH_SIZE);
+
+	return found;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: copy value from filled hash table to buffer
+//-----------------------------------------------------------------------------
+
+int ini_copy_data(struct ini_data *data, const char *section, const char *key, char *buffer, size_t size, size_t *length)
+{
+	struct ini_entry *entry = ini_lookup(data, section, key);
+
+	if (!entry)
+		return 0;
+
+	if (length)
+		*length = entry->value_length;
+
+	if (entry->value_length >= size)
+	{
+		if (size > 0)
+		{
+			memcpy(buffer, entry->value, size - 1);
+			buffer[size - 1] = '\0';
+		}
+
+		return ini_default_result(INI_ERROR_BUFFER_TOO_SMALL);
+	}
+
+	memcpy(buffer, entry->value, entry->value_length);
+	buffer[entry->value_length] = '\0';
+
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: free string of INI_FIELD_CSTRING
+//-----------------------------------------------------------------------------
+
+void ini_free_string(const char *string)
+{
+	free((void *)string);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: convert values of declared types and cache them in entries
+//
+// Return value: INI_NO_ERROR or error code of conversion
+//-----------------------------------------------------------------------------
+
+static int ini_convert_entries(struct ini_data *data, const struct ini_typed_key *types, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		// Strings are neither checked nor cached
+		if (types[i].fieldtype == INI_FIELD_CSTRING || types[i].fieldtype == INI_FIELD_STRING_VIEW)
+			continue;
+
+		struct ini_entry *entry = ini_lookup(data, types[i].section, types[i].key);
+
+		if (!entry)
+			continue;
+
+		struct ini_datatype datatype;
+
+		datatype.fieldtype = types[i].fieldtype;
+		datatype.radix = types[i].radix;
+
+		int error = ini_read_entry(entry, &datatype, -1);
+
+		if (error != INI_NO_ERROR)
+			return error;
+	}
+
+	return INI_NO_ERROR;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: convert values of parameters and cache them in filled hash table
+//-----------------------------------------------------------------------------
+
+int ini_convert_data(struct ini_data *data, const struct ini_typed_key *types, size_t count)
+{
+	return ini_default_result(ini_convert_entries(data, types, count));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: resolve section and key of hash table to handle
+//-----------------------------------------------------------------------------
+
+int ini_resolve_handle(struct ini_data *data, const char *section, const char *key, struct ini_handle *handle)
+{
+	handle->entry = ini_lookup(data, section, key);
+	handle->generation = data->generation;
+	handle->section = section;
+	handle->key = key;
+
+	return handle->entry != NULL;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: check if handle refers to the current state of hash table
+//-----------------------------------------------------------------------------
+
+int ini_is_handle_valid(const struct ini_data *data, const struct ini_handle *handle)
+{
+	return handle->entry != NULL && handle->generation != 0 && handle->generation == data->generation;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: read data using handle, stale handle is resolved again
+//-----------------------------------------------------------------------------
+
+int ini_read_handle(struct ini_data *data, struct ini_handle *handle, struct ini_datatype *datatype, int fieldtype)
+{
+	if (handle->generation != data->generation || handle->generation == 0)
+	{
+		if (!handle->section || !handle->key)
+			return 0;
+
+		ini_resolve_handle(data, handle->section, handle->key, handle);
+	}
+
+	if (!handle->entry)
+		return 0;
+
+	return ini_default_result(ini_read_entry(handle->entry, datatype, fieldtype));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: find section by name
+//-----------------------------------------------------------------------------
+
+const struct ini_section *ini_get_section(const struct ini_data *data, const char *name)
+{
+	size_t length = strlen(name);
+	return ini_find_section(data, name, length, ini_hash(name, length, 0));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: get next section in order of appearance, optionally by prefix
+//-----------------------------------------------------------------------------
+
+const struct ini_section *ini_next_section(const struct ini_data *data, const struct ini_section *section, const char *prefix)
+{
+	size_t prefixLength = prefix ? strlen(prefix) : 0;
+
+	for (size_t i = section ? section->index + 1 : 0; i < data->section_count; ++i)
+	{
+		const struct ini_section *next = data->sections[i];
+
+		if (!prefix || (next->length >= prefixLength && !memcmp(next->name, prefix, prefixLength)))
+			return next;
+	}
+
+	return NULL;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: get contiguous entries of section
+//-----------------------------------------------------------------------------
+
+const struct ini_entry *ini_get_entries(const struct ini_data *data, const struct ini_section *section, size_t *count)
+{
+	// Body of section is parsed by the first access
+	if (data->lazy && !ini_load_section((struct ini_data *)data, section))
+	{
+		*count = 0;
+		return data->entries;
+	}
+
+	*count = section->count;
+	return data->entries + section->first;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: compare names of entry of any hash table, sections of different
+// tables are interned separately so their identities can't be compared
+//-----------------------------------------------------------------------------
+
+static int ini_is_entry_named(const struct ini_entry *entry, const char *section, size_t sectionLength, const char *key, size_t keyLength)
+{
+	return entry->key_length == keyLength && entry->section->length == sectionLength && !memcmp(key, entry->key, keyLength) && !memcmp(section, entry->section->name, sectionLength);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: find entry by names and hash of section and key, without lookup of
+// section
+//-----------------------------------------------------------------------------
+
+static struct ini_entry *ini_find_named_entry(const struct ini_data *data, const char *section, size_t sectionLength, const char *key, size_t keyLength, unsigned int hash)
+{
+	if (!data->slots)
+		return NULL;
+
+	size_t mask = data->slot_count - 1;
+	size_t i = hash & mask;
+	unsigned int index;
+
+	while ((index = INI_ATOMIC_LOAD_ACQUIRE(&data->slots[i].index)))
+	{
+		if (data->slots[i].hash == hash)
+		{
+			struct ini_entry *entry = &data->entries[index - 1];
+
+			if (ini_is_entry_named(entry, section, sectionLength, key, keyLength))
+				return entry;
+		}
+
+		i = (i + 1) & mask;
+	}
+
+	return NULL;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: find overriding entry of overlay
+//-----------------------------------------------------------------------------
+
+static struct ini_overlay_entry *ini_overlay_probe(const struct ini_overlay *overlay, const char *section, size_t sectionLength, const char *key, size_t keyLength, unsigned int hash)
+{
+	if (!overlay->slots)
+		return NULL;
+
+	size_t mask = overlay->slot_count - 1;
+	size_t i = hash & mask;
+
+	while (overlay->slots[i].index)
+	{
+		if (overlay->slots[i].hash == hash)
+		{
+			struct ini_overlay_entry *override = &overlay->entries[overlay->slots[i].index - 1];
+
+			if (ini_is_entry_named(override->entry, section, sectionLength, key, keyLength))
+				return override;
+		}
+
+		i = (i + 1) & mask;
+	}
+
+	return NULL;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: find entry of layer with the highest priority
+//-----------------------------------------------------------------------------
+
+static struct ini_entry *ini_overlay_lookup(const struct ini_overlay *overlay, const char *section, const char *key)
+{
+	size_t sectionLength = strlen(section);
+	size_t keyLength = strlen(key);
+
+	// Hashes of section and key are the same in all hash tables
+	unsigned int hash = ini_hash(key, keyLength, ini_hash(section, sectionLength, 0));
+
+	struct ini_overlay_entry *override = ini_overlay_probe(overlay, section, sectionLength, key, keyLength, hash);
+
+	if (override)
+		return override->entry;
+
+	if (!overlay->base)
+		return NULL;
+
+	// Body of section of lazily parsed base is needed
+	if (overlay->base->lazy)
+	{
+		const struct ini_section *sect = ini_find_section(overlay->base, section, sectionLength, ini_hash(section, sectionLength, 0));
+
+		if (!sect || !ini_load_section(overlay->base, sect))
+			return NULL;
+	}
+
+	return ini_find_named_entry(overlay->base, section, sectionLength, key, keyLength, hash);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: initialize overlay on top of shared base hash table
+//-----------------------------------------------------------------------------
+
+void ini_overlay_init(struct ini_overlay *overlay, struct ini_data *base)
+{
+	memset(overlay, 0, sizeof(struct ini_overlay));
+	overlay->base = base;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: add layer of hash table to overlay
+//-----------------------------------------------------------------------------
+
+int ini_overlay_add(struct ini_overlay *overlay, struct ini_data *data, int priority)
+{
+	// Entries of lazily parsed layer are indexed all at once
+	if (!ini_load_sections(data))
+		return 0;
+
+	if (!data->entry_count)
+		return 1;
+
+	// Reserve for all entries of layer first, so failure leaves overlay as it was
+	size_t required = overlay->entry_count + data->entry_count;
+
+	if (required > overlay->entry_capacity)
+	{
+		size_t capacity = overlay->entry_capacity ? overlay->entry_capacity : INI_HASH_TABLE_SIZE;
+
+		while (capacity < required)
+			capacity *= 2;
+
+		void *realloc_mem = realloc(overlay->entries, capacity * sizeof(struct ini_overlay_entry));
+
+		if (!realloc_mem)
+			return 0;
+
+		overlay->entries = realloc_mem;
+		overlay->entry_capacity = capacity;
+	}
+
+	if (!ini_reserve_slots(&overlay->slots, &overlay->slot_count, required - 1))
+		return 0;
+
+	for (size_t i = 0; i < data->entry_count; ++i)
+	{
+		struct ini_entry *entry = &data->entries[i];
+		struct ini_overlay_entry *override = ini_overlay_probe(overlay, entry->section->name, entry->section->length, entry->key, entry->key_length, entry->hash);
+
+		if (override)
+		{
+			// Equal priority: layer added later wins
+			if (override->priority <= priority)
+			{
+				override->entry = entry;
+				override->priority = priority;
+			}
+
+			continue;
+		}
+
+		override = &overlay->entries[overlay->entry_count++];
+		override->entry = entry;
+		override->priority = priority;
+
+		ini_slot_insert(overlay->slots, overlay->slot_count, entry->hash, (unsigned int)overlay->entry_count);
+	}
+
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: find entry of overlay
+//-----------------------------------------------------------------------------
+
+const struct ini_entry *ini_overlay_get_entry(const struct ini_overlay *overlay, const char *section, const char *key)
+{
+	return ini_overlay_lookup(overlay, section, key);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: read data from overlay
+//-----------------------------------------------------------------------------
+
+int ini_overlay_read(struct ini_overlay *overlay, const char *section, const char *key, struct ini_datatype *datatype, int fieldtype)
+{
+	struct ini_entry *entry = ini_overlay_lookup(overlay, section, key);
+
+	if (!entry)
+		return 0;
+
+	return ini_default_result(ini_read_entry(entry, datatype, fieldtype));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: free index of overlay, its layers are left untouched
+//-----------------------------------------------------------------------------
+
+void ini_overlay_free(struct ini_overlay *overlay)
+{
+	free(overlay->entries);
+	free(overlay->slots);
+
+	memset(overlay, 0, sizeof(struct ini_overlay));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: get size of record of frozen hash table: lengths of section, key
+// and value, their strings and NUL after value
+//-----------------------------------------------------------------------------
+
+static inline size_t ini_frozen_record_size(const struct ini_entry *entry)
+{
+	size_t size = 3 * sizeof(unsigned int) + entry->section->length + entry->key_length + entry->value_length + 1;
+	return (size + INI_FROZEN_ALIGNMENT - 1) & ~(size_t)(INI_FROZEN_ALIGNMENT - 1);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: find record of parameter in frozen hash table
+//
+// Return value: record or NULL if parameter is missing
+//-----------------------------------------------------------------------------
+
+static const unsigned int *ini_frozen_find(const struct ini_frozen *frozen, const char *section, const char *key)
+{
+	if (!frozen->slots)
+		return NULL;
+
+	size_t sectionLength = strlen(section);
+	size_t keyLength = strlen(key);
+
+	unsigned int hash = ini_hash(key, keyLength, ini_hash(section, sectionLength, 0));
+
+	size_t mask = frozen->slot_count - 1;
+
+	for (size_t i = hash & mask; frozen->slots[i].index; i = (i + 1) & mask)
+	{
+		if (frozen->slots[i].hash != hash)
+			continue;
+
+		const unsigned int *record = (const unsigned int *)(frozen->records + (size_t)(frozen->slots[i].index - 1) * INI_FROZEN_ALIGNMENT);
+		const char *names = (const char *)(record + 3);
+
+		// Names are next to lengths, usually in the same cache line
+		if (record[0] == sectionLength && record[1] == keyLength && !memcmp(names, section, sectionLength) && !memcmp(names + sectionLength, key, keyLength))
+			return record;
+	}
+
+	return NULL;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: compact hash table into read-only flat layout
+//-----------------------------------------------------------------------------
+
+int ini_freeze(const struct ini_data *data, struct ini_frozen *frozen)
+{
+	memset(frozen, 0, sizeof(struct ini_frozen));
+
+	// Bodies of lazily parsed sections are needed
+	if (!ini_load_sections((struct ini_data *)data))
+		return 0;
+
+	if (!data->entry_count)
+		return 1;
+
+	// Probes stay short at load factor below 1/2
+	size_t slotCount = INI_HASH_TABLE_SIZE;
+
+	while (slotCount < data->entry_count * 2)
+		slotCount *= 2;
+
+	size_t size = 0;
+
+	for (size_t i = 0; i < data->entry_count; ++i)
+	{
+		const struct ini_entry *entry = &data->entries[i];
+
+		if (entry->section->length > UINT_MAX || entry->key_length > UINT_MAX || entry->value_length >= UINT_MAX)
+			return 0;
+
+		size += ini_frozen_record_size(entry);
+	}
+
+	// Positions of records are stored in 32 bits of slots
+	if (size / INI_FROZEN_ALIGNMENT >= UINT_MAX)
+		return 0;
+
+	// Slots and records share one allocation
+	char *memory = malloc(slotCount * sizeof(struct ini_slot) + size);
+
+	if (!memory)
+		return 0;
+
+	struct ini_slot *slots = (struct ini_slot *)memory;
+	char *records = memory + slotCount * sizeof(struct ini_slot);
+
+	memset(slots, 0, slotCount * sizeof(struct ini_slot));
+
+	size_t position = 0;
+
+	// Entries are grouped by sections, parameters of a section are close
+	for (size_t i = 0; i < data->entry_count; ++i)
+	{
+		const struct ini_entry *entry = &data->entries[i];
+		unsigned int *record = (unsigned int *)(records + position);
+		char *strings = (char *)(record + 3);
+
+		record[0] = (unsigned int)entry->section->length;
+		record[1] = (unsigned int)entry->key_length;
+		record[2] = (unsigned int)entry->value_length;
+
+		memcpy(strings, entry->section->name, entry->section->length);
+		strings += entry->section->length;
+
+		memcpy(strings, entry->key, entry->key_length);
+		strings += entry->key_length;
+
+		memcpy(strings, entry->value, entry->value_length);
+		strings[entry->value_length] = '\0';
+
+		ini_slot_insert(slots, slotCount, entry->hash, (unsigned int)(position / INI_FROZEN_ALIGNMENT + 1));
+
+		position += ini_frozen_record_size(entry);
+	}
+
+	frozen->slots = slots;
+	frozen->slot_count = slotCount;
+	frozen->records = records;
+	frozen->records_size = size;
+	frozen->entry_count = data->entry_count;
+
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: read data from frozen hash table
+//-----------------------------------------------------------------------------
+
+int ini_frozen_read(const struct ini_frozen *frozen, const char *section, const char *key, struct ini_datatype *datatype, int fieldtype)
+{
+	const unsigned int *record = ini_frozen_find(frozen, section, key);
+
+	if (!record)
+		return 0;
+
+	const char *value = (const char *)(record + 3) + record[0] + record[1];
+	return ini_default_result(ini_convert(value, record[2], datatype, fieldtype));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: free memory of frozen hash table
+//-----------------------------------------------------------------------------
+
+void ini_frozen_free(struct ini_frozen *frozen)
+{
+	// Records are in the same allocation
+	free(frozen->slots);
+	memset(frozen, 0, sizeof(struct ini_frozen));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: parse bodies of all sections of lazily parsed hash table
+//-----------------------------------------------------------------------------
+
+int ini_load_sections(struct ini_data *data)
+{
+	if (!data->lazy)
+		return 1;
+
+	for (size_t i = 0; i < data->section_count; ++i)
+	{
+		if (!ini_load_section(data, data->sections[i]))
+			return 0;
+	}
+
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: set error of missing file
+//-----------------------------------------------------------------------------
+
+static int ini_missing_file(struct ini_parser *parser)
+{
+	parser->error_code = INI_MISSING_FILE;
+	parser->line = -1;
+	parser->column = -1;
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: main function for parsing .ini files
+//-----------------------------------------------------------------------------
+
+static int ini_parse(struct ini_parser *parser, const char *filename, parse_type_t type, struct ini_data *data, iniHandlerFn handler, const struct ini_schema *schema, void *object)
+{
+	INI_STAT_CLOCK(openStart);
+
+	FILE *file = fopen(filename, "r");
+
+	if (file)
+	{
+		ini_parse_state_t state;
+		ini_init_state(&state, parser, type, data, handler, schema, object);
+
+		INI_STAT_ADD(read_time, state.startTime - openStart);
+
+		if (!ini_reserve(&parser->buffer, &parser->buffer_size, INI_BUFFER_LENGTH))
+		{
+			fclose(file);
+			return ini_finish_state(&state, ini_memory_error(parser));
+		}
+
+		char *pszFileBuffer = parser->buffer;
+
+		long int endpos;
+		fseek(file, 0, SEEK_END);
+		endpos = ftell(file);
+		rewind(file);
+
+		int success = 1;
+
+		// Read line by line
+		while (fgets(pszFileBuffer, (int)parser->buffer_size, file))
+		{
+			size_t length = strlen(pszFileBuffer);
+
+			// Increase buffer size
+			while (pszFileBuffer[length - 1] != '\n' && ftell(file) != endpos)
+			{
+				if (!ini_reserve(&parser->buffer, &parser->buffer_size, parser->buffer_size * 2))
+				{
+					fclose(file);
+					return ini_finish_state(&state, ini_memory_error(parser));
+				}
+
+				INI_STAT_ADD(buffer_growths, 1);
+
+				pszFileBuffer = parser->buffer;
+				fgets(pszFileBuffer + length, (int)(parser->buffer_size - length), file);
+
+				length = strlen(pszFileBuffer);
+			}
+
+			if (pszFileBuffer[length - 1] == '\n')
+			{
+				INI_STAT_ADD(bytes, 1);
+				--length;
+			}
+
+			if (!ini_parse_line(&state, pszFileBuffer, length))
+			{
+				success = 0;
+				break;
+			}
+		}
+
+		fclose(file);
+
+		return ini_finish_state(&state, success);
+	}
+	else
+	{
+		return ini_missing_file(parser);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: parse .ini file mapped in memory
+//-----------------------------------------------------------------------------
+
+static int ini_parse_mmap(struct ini_parser *parser, const char *filename, parse_type_t type, struct ini_data *data, iniHandlerFn handler, const struct ini_schema *schema, void *object)
+{
+	INI_STAT_CLOCK(mapStart);
+
+	void *mapping;
+	size_t size;
+
+	if (!ini_map_file(filename, &mapping, &size))
+		return ini_missing_file(parser);
+
+	ini_parse_state_t state;
+	ini_init_state(&state, parser, type, data, handler, schema, object);
+
+	INI_STAT_ADD(read_time, state.startTime - mapStart);
+
+	state.reference = 1;
+
+	// Entries refer to the mapping, it's released by ini_free_data
+	if (type == PARSE_DATA)
+	{
+		data->reference = 1;
+		data->mapping = mapping;
+		data->mapping_size = size;
+	}
+
+	int success = ini_parse_text(&state, (const char *)mapping, size);
+
+	if (type != PARSE_DATA)
+		ini_unmap_file(mapping, size);
+
+	return ini_finish_state(&state, success);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: add body of section which starts after its header
+//-----------------------------------------------------------------------------
+
+static ini_lazy_part_t *ini_lazy_add_part(ini_lazy_t *lazy, ini_parse_state_t *state, const char *text)
+{
+	if (lazy->part_count == lazy->part_capacity)
+	{
+		size_t capacity = lazy->part_capacity ? lazy->part_capacity * 2 : INI_HASH_TABLE_SIZE;
+		void *realloc_mem = realloc(lazy->parts, capacity * sizeof(ini_lazy_part_t));
+
+		if (!realloc_mem)
+			return NULL;
+
+		INI_STAT_ALLOC(capacity * sizeof(ini_lazy_part_t));
+
+		lazy->parts = realloc_mem;
+		lazy->part_capacity = capacity;
+	}
+
+	ini_lazy_part_t *part = &lazy->parts[lazy->part_count++];
+
+	part->text = text;
+	part->length = 0;
+	part->line = state->line;
+	part->lines = 0;
+	part->section = state->section->index;
+	part->next = 0;
+
+	return part;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: header failed, but skipped bodies before it can have error which is
+// found first by usual parsing, so they're parsed in order of text
+//-----------------------------------------------------------------------------
+
+static int ini_lazy_scan_error(ini_parse_state_t *state, const ini_lazy_t *lazy)
+{
+	struct ini_parser parser;
+	ini_parser_init(&parser, 0);
+
+	ini_parse_state_t body;
+	memset(&body, 0, sizeof(ini_parse_state_t));
+
+	body.parser = &parser;
+	body.type = PARSE_DATA;
+	body.data = state->data;
+	body.reference = 1;
+
+	for (size_t i = 0; i < lazy->part_count; ++i)
+	{
+		const ini_lazy_part_t *part = &lazy->parts[i];
+
+		body.section = state->data->sections[part->section];
+		body.line = part->line;
+		body.parsingSection = 0;
+
+		if (!ini_parse_text(&body, part->text, part->length))
+		{
+			state->parser->error_code = parser.error_code;
+			state->parser->line = parser.line;
+			state->parser->column = parser.column;
+
+			break;
+		}
+	}
+
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: the first pass of lazy parsing, headers of sections are parsed and
+// bodies are only skipped line by line
+//-----------------------------------------------------------------------------
+
+static int ini_lazy_scan(ini_parse_state_t *state, ini_lazy_t *lazy, const char *text, size_t length)
+{
+	const char *end = text + length;
+	ini_lazy_part_t *part = NULL;
+	ini_line_t line;
+
+	size_t bodyLines = 0;
+
+	while (text < end)
+	{
+		const char *str = text;
+
+		while (str < end && (*str == ' ' || *str == '\t' || *str == '\r'))
+			++str;
+
+		int isHeader = (str < end && *str == INI_SECTION_PREFIX);
+
+		// Line of body, it's parsed on demand
+		if (part && !isHeader)
+		{
+			const char *newline = memchr(str, '\n', end - str);
+			text = newline ? newline + 1 : end;
+
+			++state->line;
+			++part->lines;
+			++bodyLines;
+
+			continue;
+		}
+
+		if (part)
+			part->length = text - part->text;
+
+		// Lines before the first section can be only empty or comments
+		ini_scan_line(text, end, &line);
+
+		if (!ini_parse_scanned_line(state, &line))
+			return ini_lazy_scan_error(state, lazy);
+
+		text = line.next;
+
+		if (isHeader && !(part = ini_lazy_add_part(lazy, state, text)))
+			return ini_memory_error(state->parser);
+	}
+
+	if (part)
+		part->length = end - part->text;
+
+	struct ini_data *data = state->data;
+
+	lazy->sections = calloc(data->section_count ? data->section_count : 1, sizeof(ini_lazy_section_t));
+
+	if (!lazy->sections)
+		return ini_memory_error(state->parser);
+
+	INI_STAT_ALLOC(data->section_count * sizeof(ini_lazy_section_t));
+
+	// Chain parts of repeated sections
+	for (size_t i = 0; i < lazy->part_count; ++i)
+	{
+		ini_lazy_section_t *section = &lazy->sections[lazy->parts[i].section];
+
+		if (section->last)
+			lazy->parts[section->last - 1].next = i + 1;
+		else
+			section->first = i + 1;
+
+		section->last = i + 1;
+	}
+
+	// Each line of body holds at most one entry, so entries and index never
+	// grow and don't move while other sections are read
+	if (bodyLines)
+	{
+		data->entries = malloc(bodyLines * sizeof(struct ini_entry));
+
+		if (!data->entries)
+			return ini_memory_error(state->parser);
+
+		INI_STAT_ALLOC(bodyLines * sizeof(struct ini_entry));
+
+		data->entry_capacity = bodyLines;
+
+		if (!ini_reserve_slots(&data->slots, &data->slot_count, bodyLines))
+			return ini_memory_error(state->parser);
+	}
+
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: parse body of section into hash table, called under lock
+//
+// Return value: INI_LAZY_LOADED or INI_LAZY_FAILED
+//-----------------------------------------------------------------------------
+
+static unsigned int ini_lazy_parse_section(struct ini_data *data, ini_lazy_t *lazy, size_t index)
+{
+	struct ini_section *section = data->sections[index];
+	ini_lazy_section_t *lazySection = &lazy->sections[index];
+
+	struct ini_parser parser;
+	ini_parser_init(&parser, 0);
+
+	ini_parse_state_t state;
+	memset(&state, 0, sizeof(ini_parse_state_t));
+
+	state.parser = &parser;
+	state.type = PARSE_DATA;
+	state.data = data;
+	state.reference = 1;
+	state.section = section;
+
+	int success = 1;
+
+	// Parts of repeated section are joined, so its entries are contiguous
+	section->first = data->entry_count;
+
+	for (size_t i = lazySection->first; success && i; i = lazy->parts[i - 1].next)
+	{
+		const ini_lazy_part_t *part = &lazy->parts[i - 1];
+
+		state.line = part->line;
+		state.parsingSection = 0;
+
+		success = ini_parse_text(&state, part->text, part->length);
+	}
+
+	// Entries of failed section stay in index but they're never reached
+	section->count = success ? data->entry_count - section->first : 0;
+
+	if (!success)
+	{
+		lazySection->error_code = parser.error_code;
+		lazySection->line = parser.line;
+		lazySection->column = parser.column;
+	}
+
+	return success ? INI_LAZY_LOADED : INI_LAZY_FAILED;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: make sure body of section of lazily parsed hash table is parsed
+//
+// Return value: 1 - section is parsed, 0 - its body has error (it's set in
+// default context)
+//-----------------------------------------------------------------------------
+
+static int ini_load_section(struct ini_data *data, const struct ini_section *section)
+{
+	ini_lazy_t *lazy = (ini_lazy_t *)data->lazy;
+	ini_lazy_section_t *lazySection = &lazy->sections[section->index];
+
+	unsigned int state = INI_ATOMIC_LOAD_ACQUIRE(&lazySection->state);
+
+	if (state == INI_LAZY_PENDING)
+	{
+#ifdef _WIN32
+		EnterCriticalSection(&lazy->lock);
+#else
+		pthread_mutex_lock(&lazy->lock);
+#endif
+
+		// Other thread could parse it meanwhile
+		state = lazySection->state;
+
+		if (state == INI_LAZY_PENDING)
+		{
+			state = ini_lazy_parse_section(data, lazy, section->index);
+			INI_ATOMIC_STORE_RELEASE(&lazySection->state, state);
+		}
+
+#ifdef _WIN32
+		LeaveCriticalSection(&lazy->lock);
+#else
+		pthread_mutex_unlock(&lazy->lock);
+#endif
+	}
+
+	if (state == INI_LAZY_FAILED)
+	{
+		s_default_parser.error_code = lazySection->error_code;
+		s_default_parser.line = lazySection->line;
+		s_default_parser.column = lazySection->column;
+
+		return 0;
+	}
+
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: free state of lazily parsed hash table
+//-----------------------------------------------------------------------------
+
+static void ini_lazy_free(ini_lazy_t *lazy)
+{
+	if (!lazy)
+		return;
+
+#ifdef _WIN32
+	DeleteCriticalSection(&lazy->lock);
+#else
+	pthread_mutex_destroy(&lazy->lock);
+#endif
+
+	free(lazy->parts);
+	free(lazy->sections);
+	free(lazy);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: map file and find its sections, bodies are parsed on first access
+//-----------------------------------------------------------------------------
+
+static int ini_parse_lazy(struct ini_parser *parser, const char *filename, struct ini_data *data)
+{
+	INI_STAT_CLOCK(mapStart);
+
+	void *mapping;
+	size_t size;
+
+	if (!ini_map_file(filename, &mapping, &size))
+		return ini_missing_file(parser);
+
+	ini_parse_state_t state;
+	ini_init_state(&state, parser, PARSE_DATA, data, NULL, NULL, NULL);
+
+	INI_STAT_ADD(read_time, state.startTime - mapStart);
+
+	state.reference = 1;
+
+	data->reference = 1;
+	data->mapping = mapping;
+	data->mapping_size = size;
+
+	ini_lazy_t *lazy = calloc(1, sizeof(ini_lazy_t));
+
+	if (!lazy)
+		return ini_finish_state(&state, ini_memory_error(parser));
+
+	INI_STAT_ALLOC(sizeof(ini_lazy_t));
+
+#ifdef _WIN32
+	InitializeCriticalSection(&lazy->lock);
+#else
+	pthread_mutex_init(&lazy->lock, NULL);
+#endif
+
+	data->lazy = lazy;
+
+	return ini_finish_state(&state, ini_lazy_scan(&state, lazy, (const char *)mapping, size));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: parse .ini text in memory
+//-----------------------------------------------------------------------------
+
+static int ini_parse_buffer(struct ini_parser *parser, const char *buffer, size_t length, parse_type_t type, struct ini_data *data, iniHandlerFn handler, const struct ini_schema *schema, void *object)
+{
+	ini_parse_state_t state;
+	ini_init_state(&state, parser, type, data, handler, schema, object);
+
+	state.reference = (parser->options & INI_OPTION_REFERENCE) != 0;
+
+	if (type == PARSE_DATA)
+		data->reference = state.reference;
+
+	return ini_finish_state(&state, ini_parse_text(&state, buffer, length));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: get number of logical processors
+//-----------------------------------------------------------------------------
+
+static int ini_cpu_count()
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+
+	return (int)info.dwNumberOfProcessors;
+#else
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return count > 0 ? (int)count : 1;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: run tasks of queue until none is left
+//-----------------------------------------------------------------------------
+
+#ifdef _WIN32
+static DWORD WINAPI ini_task_thread(LPVOID parameter)
+#else
+static void *ini_task_thread(void *parameter)
+#endif
+{
+	ini_task_queue_t *queue = (ini_task_queue_t *)parameter;
+	size_t index;
+
+	while ((index = INI_ATOMIC_ADD(&queue->next, 1) - 1) < queue->count)
+		queue->function(queue->tasks + index * queue->taskSize);
+
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: run array of tasks on threads, calling thread takes part too
+//-----------------------------------------------------------------------------
+
+static void ini_run_tasks(ini_task_fn function, void *tasks, size_t taskSize, size_t count, int threads)
+{
+	ini_task_queue_t queue = { function, (char *)tasks, taskSize, count, 0 };
+
+	if (threads <= 0)
+		threads = ini_cpu_count();
+
+	if ((size_t)threads > count)
+		threads = (int)count;
+
+	int started = 0;
+
+#ifdef _WIN32
+	HANDLE *handles = (threads > 1) ? malloc((threads - 1) * sizeof(HANDLE)) : NULL;
+
+	for (; handles && started < threads - 1; ++started)
+	{
+		if (!(handles[started] = CreateThread(NULL, 0, ini_task_thread, &queue, 0, NULL)))
+			break;
+	}
+#else
+	pthread_t *handles = (threads > 1) ? malloc((threads - 1) * sizeof(pthread_t)) : NULL;
+
+	for (; handles && started < threads - 1; ++started)
+	{
+		if (pthread_create(&handles[started], NULL, ini_task_thread, &queue) != 0)
+			break;
+	}
+#endif
+
+	// Threads which failed to start are replaced by this one
+	ini_task_thread(&queue);
+
+	for (int i = 0; i < started; ++i)
+	{
+#ifdef _WIN32
+		WaitForSingleObject(handles[i], INFINITE);
+		CloseHandle(handles[i]);
+#else
+		pthread_join(handles[i], NULL);
+#endif
+	}
+
+	free(handles);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: find start of line which begins a section at or after position
+//-----------------------------------------------------------------------------
+
+static size_t ini_section_boundary(const char *text, size_t length, size_t position)
+{
+	// Move to start of line
+	if (position > 0 && text[position - 1] != '\n')
+	{
+		const char *newline = memchr(text + position, '\n', length - position);
+
+		if (!newline)
+			return length;
+
+		position = newline - text + 1;
+	}
+
+	while (position < length)
+	{
+		const char *str = text + position;
+		const char *end = text + length;
+
+		while (str < end && (*str == ' ' || *str == '\t' || *str == '\r'))
+			++str;
+
+		if (str < end && *str == INI_SECTION_PREFIX)
+			return position;
+
+		const char *newline = memchr(str, '\n', end - str);
+
+		if (!newline)
+			return length;
+
+		position = newline - text + 1;
+	}
+
+	return length;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: parse part of text into its own table
+//-----------------------------------------------------------------------------
+
+static void ini_parse_chunk(void *task)
+{
+	ini_chunk_t *chunk = (ini_chunk_t *)task;
+	ini_parse_state_t state;
+
+	ini_parser_init(&chunk->parser, 0);
+
+#ifdef INI_STATS
+	chunk->parser.stats = &chunk->stats;
+#endif
+
+	ini_init_state(&state, &chunk->parser, PARSE_DATA, &chunk->data, NULL, NULL, NULL);
+
+	state.reference = chunk->reference;
+	chunk->data.reference = chunk->reference;
+
+	int success = ini_parse_text(&state, chunk->text, chunk->length);
+
+	chunk->lines = state.line;
+	chunk->success = ini_finish_state(&state, success);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: move sections and entries of part into the whole table, strings
+// stay where they are
+//-----------------------------------------------------------------------------
+
+static int ini_merge_chunk(struct ini_data *data, ini_chunk_t *chunk)
+{
+	struct ini_arena *arena = &chunk->data.arena;
+
+	// Adopt chunks of arena behind the current one
+	if (arena->head)
+	{
+		struct ini_arena_chunk *tail = arena->head;
+
+		while (tail->next)
+			tail = tail->next;
+
+		if (data->arena.head)
+		{
+			tail->next = data->arena.head->next;
+			data->arena.head->next = arena->head;
+		}
+		else
+		{
+			data->arena.head = arena->head;
+		}
+
+		data->arena.used += arena->used;
+		data->arena.reserved += arena->reserved;
+
+		memset(arena, 0, sizeof(struct ini_arena));
+	}
+
+	// Keep order of first appearance of sections
+	for (size_t i = 0; i < chunk->data.section_count; ++i)
+	{
+		const struct ini_section *section = chunk->data.sections[i];
+
+		if (!ini_intern_section(data, section->name, section->length, 1))
+			return 0;
+	}
+
+	const struct ini_section *chunkSection = NULL;
+	const struct ini_section *section = NULL;
+
+	for (size_t i = 0; i < chunk->data.entry_count; ++i)
+	{
+		struct ini_entry entry = chunk->data.entries[i];
+
+		if (entry.section != chunkSection)
+		{
+			chunkSection = entry.section;
+			section = ini_find_section(data, chunkSection->name, chunkSection->length, chunkSection->hash);
+		}
+
+		// Hash of entry depends only on names
+		entry.section = section;
+
+		if (!ini_add_entry(data, &entry))
+			return 0;
+	}
+
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: split text at sections, parse parts in parallel and merge them
+//-----------------------------------------------------------------------------
+
+static int ini_parse_parallel(struct ini_parser *parser, const char *text, size_t length, int reference, int isMapping, struct ini_data *data, int threads)
+{
+	ini_parse_state_t state;
+	ini_init_state(&state, parser, PARSE_DATA, data, NULL, NULL, NULL);
+
+	state.reference = reference;
+	data->reference = reference;
+
+	// Entries refer to the mapping, it's released by ini_free_data
+	if (isMapping)
+	{
+		data->mapping = (void *)text;
+		data->mapping_size = length;
+	}
+
+	if (threads <= 0)
+		threads = ini_cpu_count();
+
+	size_t chunkCount = length / INI_PARALLEL_CHUNK_SIZE;
+
+	// Several parts per thread balance sections of different sizes
+	if (chunkCount > (size_t)threads * 4)
+		chunkCount = (size_t)threads * 4;
+
+	if (chunkCount < 1 || threads == 1)
+		chunkCount = 1;
+
+	ini_chunk_t *chunks = calloc(chunkCount, sizeof(ini_chunk_t));
+
+	if (!chunks)
+		return ini_finish_state(&state, ini_memory_error(parser));
+
+	size_t count = 0;
+	size_t start = 0;
+
+	for (size_t i = 1; i <= chunkCount && start < length; ++i)
+	{
+		size_t target = (i == chunkCount) ? length : length / chunkCount * i;
+		size_t end = ini_section_boundary(text, length, target > start ? target : start + 1);
+
+		chunks[count].text = text + start;
+		chunks[count].length = end - start;
+		chunks[count].reference = reference;
+
+		++count;
+		start = end;
+	}
+
+	ini_run_tasks(ini_parse_chunk, chunks, sizeof(ini_chunk_t), count, threads);
+
+	int success = 1;
+	int line = 0;
+
+	size_t entryCount = 0;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		entryCount += chunks[i].data.entry_count;
+
+#ifdef INI_STATS
+		// Time of parts overlaps, the whole parsing is measured instead
+		INI_STAT_ADD(bytes, chunks[i].stats.bytes);
+		INI_STAT_ADD(lines, chunks[i].stats.lines);
+		INI_STAT_ADD(entries, chunks[i].stats.entries);
+		INI_STAT_ADD(sections, chunks[i].stats.sections);
+		INI_STAT_ADD(allocations, chunks[i].stats.allocations);
+		INI_STAT_ADD(allocated_bytes, chunks[i].stats.allocated_bytes);
+#endif
+	}
+
+	// Parts after the first error aren't reached by serial parsing
+	for (size_t i = 0; i < count && success; ++i)
+	{
+		if (!chunks[i].success)
+		{
+			parser->error_code = chunks[i].parser.error_code;
+			parser->line = (chunks[i].parser.line != -1) ? line + chunks[i].parser.line : -1;
+			parser->column = chunks[i].parser.column;
+
+			success = 0;
+			break;
+		}
+
+		line += chunks[i].lines;
+
+		if (i == 0)
+		{
+			// The first part becomes the whole table, others are merged into it
+			struct ini_data *first = &chunks[0].data;
+
+			data->entries = first->entries;
+			data->entry_count = first->entry_count;
+			data->entry_capacity = first->entry_capacity;
+			data->slots = first->slots;
+			data->slot_count = first->slot_count;
+			data->sections = first->sections;
+			data->section_count = first->section_count;
+			data->section_capacity = first->section_capacity;
+			data->section_slots = first->section_slots;
+			data->section_slot_count = first->section_slot_count;
+			data->arena = first->arena;
+
+			memset(first, 0, sizeof(struct ini_data));
+
+			// Grow index once
+			if (!ini_reserve_slots(&data->slots, &data->slot_count, entryCount))
+				success = ini_memory_error(parser);
+		}
+		else if (!ini_merge_chunk(data, &chunks[i]))
+		{
+			success = ini_memory_error(parser);
+		}
+	}
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		ini_free_data(&chunks[i].data, 0);
+		ini_parser_free(&chunks[i].parser);
+	}
+
+	free(chunks);
+
+	// Entries moved to the whole table
+	data->generation = ini_next_generation();
+
+	return ini_finish_state(&state, success);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: map .ini file and parse it in parallel
+//-----------------------------------------------------------------------------
+
+static int ini_parse_mmap_parallel(struct ini_parser *parser, const char *filename, struct ini_data *data, int threads)
+{
+	void *mapping;
+	size_t size;
+
+	if (!ini_map_file(filename, &mapping, &size))
+		return ini_missing_file(parser);
+
+	return ini_parse_parallel(parser, (const char *)mapping, size, 1, 1, data, threads);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: read whole file into buffer by one request
+// Return value: INI_NO_ERROR, INI_MISSING_FILE or INI_ERROR_OUT_OF_MEMORY
+//-----------------------------------------------------------------------------
+
+static int ini_read_file(const char *filename, char **buffer, size_t *bufferSize, size_t *size)
+{
+	*size = 0;
+
+#ifdef _WIN32
+	HANDLE hFile = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+	if (hFile == INVALID_HANDLE_VALUE)
+		return INI_MISSING_FILE;
+
+	LARGE_INTEGER fileSize;
+
+	if (!GetFileSizeEx(hFile, &fileSize) || (unsigned long long)fileSize.QuadPart >= (size_t)-1)
+	{
+		CloseHandle(hFile);
+		return INI_MISSING_FILE;
+	}
+
+	if (!ini_reserve(buffer, bufferSize, (size_t)fileSize.QuadPart + 1))
+	{
+		CloseHandle(hFile);
+		return INI_ERROR_OUT_OF_MEMORY;
+	}
+
+	DWORD bytes;
+
+	// File could be shortened meanwhile
+	while (*size < (size_t)fileSize.QuadPart && ReadFile(hFile, *buffer + *size, (DWORD)(((size_t)fileSize.QuadPart - *size) > 0x40000000 ? 0x40000000 : (size_t)fileSize.QuadPart - *size), &bytes, NULL) && bytes > 0)
+		*size += bytes;
+
+	CloseHandle(hFile);
+#else
+	int fd = open(filename, O_RDONLY);
+
+	if (fd == -1)
+		return INI_MISSING_FILE;
+
+	struct stat st;
+
+	if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) || (unsigned long long)st.st_size >= (size_t)-1)
+	{
+		close(fd);
+		return INI_MISSING_FILE;
+	}
+
+	if (!ini_reserve(buffer, bufferSize, (size_t)st.st_size + 1))
+	{
+		close(fd);
+		return INI_ERROR_OUT_OF_MEMORY;
+	}
+
+	ssize_t bytes;
+
+	// File could be shortened meanwhile
+	while (*size < (size_t)st.st_size && ((bytes = read(fd, *buffer + *size, (size_t)st.st_size - *size)) > 0 || (bytes == -1 && errno == EINTR)))
+	{
+		if (bytes > 0)
+			*size += (size_t)bytes;
+	}
+
+	close(fd);
+#endif
+
+	return INI_NO_ERROR;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: load files until none is left, each one is read at once and parsed
+// from memory, names are interned in set of this thread
+//-----------------------------------------------------------------------------
+
+static void ini_load_files_task(void *task)
+{
+	ini_loader_t *loader = (ini_loader_t *)task;
+	size_t index;
+
+	while ((index = INI_ATOMIC_ADD(loader->next, 1) - 1) < loader->files->count)
+	{
+		struct ini_file *file = &loader->files->files[index];
+		size_t size;
+		int error = ini_read_file(file->filename, &loader->buffer, &loader->bufferSize, &size);
+
+		if (error != INI_NO_ERROR)
+		{
+			memset(&file->data, 0, sizeof(struct ini_data));
+			file->error_code = error;
+			file->line = -1;
+			file->column = -1;
+			continue;
+		}
+
+		struct ini_parser parser;
+		ini_parser_init(&parser, 0);
+
+		ini_parse_state_t state;
+		ini_init_state(&state, &parser, PARSE_DATA, &file->data, NULL, NULL, NULL);
+
+		state.strings = &loader->strings;
+
+		// Strings and sections are allocated in arena of loader, table doesn't own them
+		file->data.arena = loader->arena;
+
+		int success = ini_parse_text(&state, loader->buffer, size);
+
+		loader->arena = file->data.arena;
+		memset(&file->data.arena, 0, sizeof(struct ini_arena));
+
+		// Failure without error of parsing is failed allocation, empty table isn't success
+		if (!ini_finish_state(&state, success) && parser.error_code == INI_NO_ERROR)
+			ini_memory_error(&parser);
+
+		file->error_code = parser.error_code;
+		file->line = parser.line;
+		file->column = parser.column;
+
+		ini_parser_free(&parser);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: load named files of set on threads
+//-----------------------------------------------------------------------------
+
+static int ini_load_files(struct ini_files *files, int threads)
+{
+	if (!files->count)
+		return 1;
+
+	if (threads <= 0)
+		threads = ini_cpu_count();
+
+	if ((size_t)threads > files->count)
+		threads = (int)files->count;
+
+	ini_loader_t *loaders = calloc(threads, sizeof(ini_loader_t));
+	files->arenas = calloc(threads, sizeof(struct ini_arena));
+
+	if (!loaders || !files->arenas)
+	{
+		free(loaders);
+		free(files->arenas);
+
+		// No file is loaded, each one has failed with empty table
+		for (size_t i = 0; i < files->count; ++i)
+		{
+			files->files[i].error_code = INI_ERROR_OUT_OF_MEMORY;
+			files->files[i].line = -1;
+			files->files[i].column = -1;
+		}
+
+		files->arenas = NULL;
+		return ini_default_result(INI_ERROR_OUT_OF_MEMORY);
+	}
+
+	unsigned int next = 0;
+
+	for (int i = 0; i < threads; ++i)
+	{
+		loaders[i].files = files;
+		loaders[i].next = &next;
+	}
+
+	// One task per thread, every task takes files from the shared counter
+	ini_run_tasks(ini_load_files_task, loaders, sizeof(ini_loader_t), threads, threads);
+
+	for (int i = 0; i < threads; ++i)
+	{
+		files->arenas[i] = loaders[i].arena;
+
+		free(loaders[i].strings.strings);
+		free(loaders[i].strings.slots);
+		free(loaders[i].buffer);
+	}
+
+	files->arena_count = threads;
+	free(loaders);
+
+	// The first failed file is reported in default context too
+	for (size_t i = 0; i < files->count; ++i)
+	{
+		if (files->files[i].error_code != INI_NO_ERROR)
+		{
+			s_default_parser.error_code = files->files[i].error_code;
+			s_default_parser.line = files->files[i].line;
+			s_default_parser.column = files->files[i].column;
+
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: add file to set which is being filled
+//-----------------------------------------------------------------------------
+
+static int ini_add_file(struct ini_files *files, size_t *capacity, const char *directory, const char *name)
+{
+	if (files->count == *capacity)
+	{
+		size_t newCapacity = *capacity ? *capacity * 2 : INI_HASH_TABLE_SIZE;
+		void *realloc_mem = realloc(files->files, newCapacity * sizeof(struct ini_file));
+
+		if (!realloc_mem)
+			return 0;
+
+		files->files = realloc_mem;
+		*capacity = newCapacity;
+	}
+
+	size_t directoryLength = directory ? strlen(directory) : 0;
+	size_t nameLength = strlen(name);
+
+	char *filename = malloc(directoryLength + nameLength + 2);
+
+	if (!filename)
+		return 0;
+
+	if (directory)
+	{
+		memcpy(filename, directory, directoryLength);
+
+		// Separator of path is added if it's missing
+		if (directoryLength && directory[directoryLength - 1] != '/' && directory[directoryLength - 1] != '\\')
+			filename[directoryLength++] = '/';
+	}
+
+	memcpy(filename + directoryLength, name, nameLength + 1);
+
+	struct ini_file *file = &files->files[files->count++];
+
+	memset(file, 0, sizeof(struct ini_file));
+	file->filename = filename;
+	file->error_code = INI_NO_ERROR;
+	file->line = -1;
+	file->column = -1;
+
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: compare files by names
+//-----------------------------------------------------------------------------
+
+static int ini_compare_files(const void *first, const void *second)
+{
+	return strcmp(((const struct ini_file *)first)->filename, ((const struct ini_file *)second)->filename);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: check if name of file ends with extension
+//-----------------------------------------------------------------------------
+
+static int ini_has_extension(const char *name, const char *extension)
+{
+	if (!extension)
+		return 1;
+
+	size_t length = strlen(name);
+	size_t extensionLength = strlen(extension);
+
+	return length >= extensionLength && !strcmp(name + length - extensionLength, extension);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: load list of files in parallel
+//-----------------------------------------------------------------------------
+
+int ini_parse_files(const char *const *filenames, size_t count, struct ini_files *files, int threads)
+{
+	memset(files, 0, sizeof(struct ini_files));
+
+	size_t capacity = 0;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (!ini_add_file(files, &capacity, NULL, filenames[i]))
+		{
+			ini_free_files(files);
+			return ini_default_result(INI_ERROR_OUT_OF_MEMORY);
+		}
+	}
+
+	return ini_load_files(files, threads);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: load files of directory in parallel in order of their names
+//-----------------------------------------------------------------------------
+
+int ini_parse_directory(const char *directory, const char *extension, struct ini_files *files, int threads)
+{
+	memset(files, 0, sizeof(struct ini_files));
+
+	size_t capacity = 0;
+	int success = 1;
+
+#ifdef _WIN32
+	size_t length = strlen(directory);
+	char *pattern = malloc(length + 3);
+
+	if (!pattern)
+		return ini_default_result(INI_ERROR_OUT_OF_MEMORY);
+
+	memcpy(pattern, directory, length);
+	memcpy(pattern + length, (length && (directory[length - 1] == '/' || directory[length - 1] == '\\')) ? "*" : "\\*", 3);
+
+	WIN32_FIND_DATAA found;
+	HANDLE hFind = FindFirstFileA(pattern, &found);
+
+	free(pattern);
+
+	if (hFind == INVALID_HANDLE_VALUE)
+		return ini_missing_file(&s_default_parser);
+
+	do
+	{
+		if (!(found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && ini_has_extension(found.cFileName, extension))
+			success = ini_add_file(files, &capacity, directory, found.cFileName);
+	} while (success && FindNextFileA(hFind, &found));
+
+	FindClose(hFind);
+#else
+	DIR *dir = opendir(directory);
+
+	if (!dir)
+		return ini_missing_file(&s_default_parser);
+
+	struct dirent *entry;
+
+	while (success && (entry = readdir(dir)) != NULL)
+	{
+		const char *name = entry->d_name;
+
+		// Files of unknown type which aren't regular fail when they're read
+		if (!strcmp(name, ".") || !strcmp(name, "..") || !ini_has_extension(name, extension))
+			continue;
+
+	#ifdef DT_DIR
+		if (entry->d_type == DT_DIR)
+			continue;
+	#endif
+
+		success = ini_add_file(files, &capacity, directory, name);
+	}
+
+	closedir(dir);
+#endif
+
+	if (!success)
+	{
+		ini_free_files(files);
+		return ini_default_result(INI_ERROR_OUT_OF_MEMORY);
+	}
+
+	// Order of listing isn't defined, later files override earlier ones when merged
+	if (files->count)
+		qsort(files->files, files->count, sizeof(struct ini_file), ini_compare_files);
+
+	return ini_load_files(files, threads);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: stack loaded files in overlay in their order
+//-----------------------------------------------------------------------------
+
+int ini_merge_files(struct ini_files *files, struct ini_overlay *overlay)
+{
+	ini_overlay_init(overlay, NULL);
+
+	// With equal priorities the layer added later wins
+	for (size_t i = 0; i < files->count; ++i)
+	{
+		if (files->files[i].error_code == INI_NO_ERROR && !ini_overlay_add(overlay, &files->files[i].data, 0))
+		{
+			ini_overlay_free(overlay);
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: free tables, names and strings of loaded files
+//-----------------------------------------------------------------------------
+
+void ini_free_files(struct ini_files *files)
+{
+	for (size_t i = 0; i < files->count; ++i)
+	{
+		ini_free_data(&files->files[i].data, 0);
+		free(files->files[i].filename);
+	}
+
+	for (size_t i = 0; i < files->arena_count; ++i)
+		ini_arena_free(&files->arenas[i]);
+
+	free(files->files);
+	free(files->arenas);
+
+	memset(files, 0, sizeof(struct ini_files));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: release buffer of default context, keep its last error
+//-----------------------------------------------------------------------------
+
+static int ini_release_default_parser(int result)
+{
+	free(s_default_parser.buffer);
+
+	s_default_parser.buffer = NULL;
+	s_default_parser.buffer_size = 0;
+
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: initialize context of parser
+//-----------------------------------------------------------------------------
+
+void ini_parser_init(struct ini_parser *parser, int options)
+{
+	memset(parser, 0, sizeof(struct ini_parser));
+
+	parser->error_code = INI_NO_ERROR;
+	parser->line = -1;
+	parser->column = -1;
+	parser->options = options;
+}
+
+#ifdef INI_STATS
+//-----------------------------------------------------------------------------
+// Purpose: collect statistics of incremental parsing during call, they're
+// restored by ini_finish_state or by caller
+//-----------------------------------------------------------------------------
+
+static void ini_stream_attach(ini_stream_t *stream)
+{
+	stream->state.previousStats = s_stats;
+	s_stats = stream->state.parser->stats;
+}
+#endif
+
+//-----------------------------------------------------------------------------
+// Purpose: free allocated memory of context of parser
+//-----------------------------------------------------------------------------
+
+void ini_parser_free(struct ini_parser *parser)
+{
+	// Abort unfinished incremental parsing
+	if (parser->stream)
+	{
+#ifdef INI_STATS
+		ini_stream_attach((ini_stream_t *)parser->stream);
+#endif
+
+		ini_finish_state(&((ini_stream_t *)parser->stream)->state, 0);
+
+		free(parser->stream);
+		parser->stream = NULL;
+	}
+
+	free(parser->buffer);
+
+	parser->buffer = NULL;
+	parser->buffer_size = 0;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: declare types of parameters to convert when hash table is filled
+//-----------------------------------------------------------------------------
+
+void ini_parser_set_types(struct ini_parser *parser, const struct ini_typed_key *types, size_t count)
+{
+	parser->types = types;
+	parser->type_count = count;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: collect statistics of parsing of context
+//-----------------------------------------------------------------------------
+
+int ini_parser_set_stats(struct ini_parser *parser, struct ini_stats *stats)
+{
+#ifdef INI_STATS
+	parser->stats = stats;
+	return 1;
+#else
+	(void)stats;
+
+	parser->stats = NULL;
+	return 0;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: start incremental parsing in context of parser
+//-----------------------------------------------------------------------------
+
+static int ini_stream_begin(struct ini_parser *parser, parse_type_t type, struct ini_data *data, iniHandlerFn handler, const struct ini_schema *schema, void *object)
+{
+	ini_stream_t *stream = malloc(sizeof(ini_stream_t));
+
+	if (!stream)
+		return ini_memory_error(parser);
+
+	// Drop previous unfinished parsing
+	if (parser->stream)
+		ini_parser_free(parser);
+
+	// Chunks don't outlive calls, so strings are always copied
+	ini_init_state(&stream->state, parser, type, data, handler, schema, object);
+	stream->pending = 0;
+
+#ifdef INI_STATS
+	// Statistics are collected only inside of calls
+	s_stats = stream->state.previousStats;
+#endif
+
+	parser->stream = stream;
+	parser->error_code = INI_NO_ERROR;
+	parser->line = -1;
+	parser->column = -1;
+
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: finish incremental parsing
+//-----------------------------------------------------------------------------
+
+static int ini_stream_end(struct ini_parser *parser, int success)
+{
+	ini_stream_t *stream = (ini_stream_t *)parser->stream;
+
+	parser->stream = NULL;
+	success = ini_finish_state(&stream->state, success);
+
+	free(stream);
+	return success;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: start incremental parsing to fill hash table
+//-----------------------------------------------------------------------------
+
+int ini_parser_begin_data(struct ini_parser *parser, struct ini_data *data)
+{
+	return ini_stream_begin(parser, PARSE_DATA, data, NULL, NULL, NULL);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: start incremental parsing calling a callback
+//-----------------------------------------------------------------------------
+
+int ini_parser_begin_handler(struct ini_parser *parser, iniHandlerFn handler)
+{
+	return ini_stream_begin(parser, PARSE_HANDLER, NULL, handler, NULL, NULL);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: start incremental parsing into structure
+//-----------------------------------------------------------------------------
+
+int ini_parser_begin_schema(struct ini_parser *parser, const struct ini_schema *schema, void *object)
+{
+	return ini_stream_begin(parser, PARSE_SCHEMA, NULL, NULL, schema, object);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: parse complete lines of chunk, keep incomplete line in buffer
+//-----------------------------------------------------------------------------
+
+static int ini_stream_feed(struct ini_parser *parser, ini_stream_t *stream, const char *chunk, size_t length)
+{
+	const char *end = chunk + length;
+
+	// Complete pending line first
+	if (stream->pending)
+	{
+		const char *newline = memchr(chunk, '\n', length);
+		size_t part = newline ? (size_t)(newline - chunk) + 1 : length;
+
+		if (!ini_reserve(&parser->buffer, &parser->buffer_size, stream->pending + part))
+			return ini_stream_end(parser, ini_memory_error(parser));
+
+		memcpy(parser->buffer + stream->pending, chunk, part);
+
+		stream->pending += part;
+		chunk += part;
+
+		if (!newline)
+			return 1;
+
+		size_t pending = stream->pending;
+		stream->pending = 0;
+
+		if (!ini_parse_text(&stream->state, parser->buffer, pending))
+			return ini_stream_end(parser, 0);
+	}
+
+	const char *lastLine = end;
+
+	while (lastLine > chunk && *(lastLine - 1) != '\n')
+		--lastLine;
+
+	// Lines in place
+	if (lastLine > chunk && !ini_parse_text(&stream->state, chunk, lastLine - chunk))
+		return ini_stream_end(parser, 0);
+
+	// Keep the rest until its newline comes
+	if (lastLine < end)
+	{
+		if (!ini_reserve(&parser->buffer, &parser->buffer_size, end - lastLine))
+			return ini_stream_end(parser, ini_memory_error(parser));
+
+		memcpy(parser->buffer, lastLine, end - lastLine);
+		stream->pending = end - lastLine;
+	}
+
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: parse chunk of text in context of parser
+//-----------------------------------------------------------------------------
+
+int ini_parser_feed(struct ini_parser *parser, const char *chunk, size_t length)
+{
+	ini_stream_t *stream = (ini_stream_t *)parser->stream;
+
+	if (!stream)
+		return 0;
+
+#ifdef INI_STATS
+	struct ini_stats *previous = s_stats;
+	size_t bufferSize = parser->buffer_size;
+
+	ini_stream_attach(stream);
+#endif
+
+	int success = ini_stream_feed(parser, stream, chunk, length);
+
+#ifdef INI_STATS
+	s_stats = previous;
+
+	if (parser->stats && bufferSize && parser->buffer_size != bufferSize)
+		++parser->stats->buffer_growths;
+#endif
+
+	return success;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: parse the last line and finish incremental parsing
+//-----------------------------------------------------------------------------
+
+int ini_parser_finish(struct ini_parser *parser)
+{
+	ini_stream_t *stream = (ini_stream_t *)parser->stream;
+
+	if (!stream)
+		return 0;
+
+#ifdef INI_STATS
+	ini_stream_attach(stream);
+#endif
+
+	int success = 1;
+
+	// Last line without newline
+	if (stream->pending)
+		success = ini_parse_text(&stream->state, parser->buffer, stream->pending);
+
+	return ini_stream_end(parser, success);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: get message of last error of context
+//-----------------------------------------------------------------------------
+
+const char *ini_parser_get_error_msg(const struct ini_parser *parser)
+{
+	if (parser->error_code <= INI_NO_ERROR)
+		return NULL;
+
+	return ini_error_messages[parser->error_code];
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: save data from .ini file in hash table using context of parser
+//-----------------------------------------------------------------------------
+
+int ini_parser_parse_data(struct ini_parser *parser, const char *filename, struct ini_data *data)
+{
+	if (parser->options & INI_OPTION_LAZY)
+		return ini_parse_lazy(parser, filename, data);
+
+	if (parser->options & INI_OPTION_MMAP)
+		return ini_parse_mmap(parser, filename, PARSE_DATA, data, NULL, NULL, NULL);
+
+	return ini_parse(parser, filename, PARSE_DATA, data, NULL, NULL, NULL);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: call a callback when parse .ini file using context of parser
+//-----------------------------------------------------------------------------
+
+int ini_parser_parse_handler(struct ini_parser *parser, const char *filename, iniHandlerFn handler)
+{
+	if (parser->options & INI_OPTION_MMAP)
+		return ini_parse_mmap(parser, filename, PARSE_HANDLER, NULL, handler, NULL, NULL);
+
+	return ini_parse(parser, filename, PARSE_HANDLER, NULL, handler, NULL, NULL);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: save data from .ini text in memory using context of parser
+//-----------------------------------------------------------------------------
+
+int ini_parser_parse_buffer_data(struct ini_parser *parser, const char *buffer, size_t length, struct ini_data *data)
+{
+	return ini_parse_buffer(parser, buffer, length, PARSE_DATA, data, NULL, NULL, NULL);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: call a callback when parse .ini text in memory using context
+//-----------------------------------------------------------------------------
+
+int ini_parser_parse_buffer_handler(struct ini_parser *parser, const char *buffer, size_t length, iniHandlerFn handler)
+{
+	return ini_parse_buffer(parser, buffer, length, PARSE_HANDLER, NULL, handler, NULL, NULL);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: convert parameters of .ini file into structure using context
+//-----------------------------------------------------------------------------
+
+int ini_parser_parse_schema(struct ini_parser *parser, const char *filename, const struct ini_schema *schema, void *object)
+{
+	if (parser->options & INI_OPTION_MMAP)
+		return ini_parse_mmap(parser, filename, PARSE_SCHEMA, NULL, NULL, schema, object);
+
+	return ini_parse(parser, filename, PARSE_SCHEMA, NULL, NULL, schema, object);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: convert parameters of .ini text in memory into structure using
+// context of parser
+//-----------------------------------------------------------------------------
+
+int ini_parser_parse_buffer_schema(struct ini_parser *parser, const char *buffer, size_t length, const struct ini_schema *schema, void *object)
+{
+	return ini_parse_buffer(parser, buffer, length, PARSE_SCHEMA, NULL, NULL, schema, object);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: save data from .ini file in hash table parsing parts of file in
+// parallel using context of parser
+//-----------------------------------------------------------------------------
+
+int ini_parser_parse_parallel_data(struct ini_parser *parser, const char *filename, struct ini_data *data, int threads)
+{
+	return ini_parse_mmap_parallel(parser, filename, data, threads);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: save data from .ini text in memory in hash table parsing parts of
+// text in parallel using context of parser
+//-----------------------------------------------------------------------------
+
+int ini_parser_parse_buffer_parallel_data(struct ini_parser *parser, const char *buffer, size_t length, struct ini_data *data, int threads)
+{
+	return ini_parse_parallel(parser, buffer, length, (parser->options & INI_OPTION_REFERENCE) != 0, 0, data, threads);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: wrapper to save .ini data in hash table
+//-----------------------------------------------------------------------------
+
+int ini_parse_data(const char *filename, struct ini_data *data)
+{
+	return ini_release_default_parser(ini_parse(&s_default_parser, filename, PARSE_DATA, data, NULL, NULL, NULL));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: wrapper to call a callback when parse .ini file
+//-----------------------------------------------------------------------------
+
+int ini_parse_handler(const char *filename, iniHandlerFn handler)
+{
+	return ini_release_default_parser(ini_parse(&s_default_parser, filename, PARSE_HANDLER, NULL, handler, NULL, NULL));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: wrapper to save .ini text in memory in hash table
+//-----------------------------------------------------------------------------
+
+int ini_parse_buffer_data(const char *buffer, size_t length, struct ini_data *data)
+{
+	return ini_parse_buffer(&s_default_parser, buffer, length, PARSE_DATA, data, NULL, NULL, NULL);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: wrapper to call a callback when parse .ini text in memory
+//-----------------------------------------------------------------------------
+
+int ini_parse_buffer_handler(const char *buffer, size_t length, iniHandlerFn handler)
+{
+	return ini_parse_buffer(&s_default_parser, buffer, length, PARSE_HANDLER, NULL, handler, NULL, NULL);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: wrapper to save data of mapped .ini file in hash table
+//-----------------------------------------------------------------------------
+
+int ini_parse_mmap_data(const char *filename, struct ini_data *data)
+{
+	return ini_parse_mmap(&s_default_parser, filename, PARSE_DATA, data, NULL, NULL, NULL);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: wrapper to call a callback when parse mapped .ini file
+//-----------------------------------------------------------------------------
+
+int ini_parse_mmap_handler(const char *filename, iniHandlerFn handler)
+{
+	return ini_parse_mmap(&s_default_parser, filename, PARSE_HANDLER, NULL, handler, NULL, NULL);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: wrapper to save data from lazily parsed .ini file in hash table
+//-----------------------------------------------------------------------------
+
+int ini_parse_lazy_data(const char *filename, struct ini_data *data)
+{
+	return ini_parse_lazy(&s_default_parser, filename, data);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: wrapper to save data of .ini file in hash table parsing it in
+// parallel
+//-----------------------------------------------------------------------------
+
+int ini_parse_parallel_data(const char *filename, struct ini_data *data, int threads)
+{
+	return ini_parse_mmap_parallel(&s_default_parser, filename, data, threads);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: wrapper to convert parameters of .ini file into structure
+//-----------------------------------------------------------------------------
+
+int ini_parse_schema(const char *filename, const struct ini_schema *schema, void *object)
+{
+	return ini_release_default_parser(ini_parse(&s_default_parser, filename, PARSE_SCHEMA, NULL, NULL, schema, object));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: wrapper to convert parameters of .ini text in memory into structure
+//-----------------------------------------------------------------------------
+
+int ini_parse_buffer_schema(const char *buffer, size_t length, const struct ini_schema *schema, void *object)
+{
+	return ini_parse_buffer(&s_default_parser, buffer, length, PARSE_SCHEMA, NULL, NULL, schema, object);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: get memory usage of arena of hash table
+//-----------------------------------------------------------------------------
+
+void ini_get_arena_usage(const struct ini_data *data, size_t *used, size_t *reserved)
+{
+	if (used)
+		*used = data->arena.used;
+
+	if (reserved)
+		*reserved = data->arena.reserved;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: measure probes and clusters of open addressing index
+//-----------------------------------------------------------------------------
+
+static void ini_index_stats(const struct ini_slot *slots, size_t slotCount, struct ini_index_stats *stats)
+{
+	memset(stats, 0, sizeof(struct ini_index_stats));
+	stats->slot_count = slotCount;
+
+	if (!slots || !slotCount)
+		return;
+
+	size_t mask = slotCount - 1;
+	size_t probes = 0;
+	size_t cluster = 0;
+
+	// Start behind empty slot so cluster wrapping around the end is whole,
+	// load factor keeps some slots empty
+	size_t start = 0;
+
+	while (start < slotCount && slots[start].index)
+		++start;
+
+	for (size_t n = 1; n <= slotCount; ++n)
+	{
+		size_t i = (start + n) & mask;
+
+		if (!slots[i].index)
+		{
+			cluster = 0;
+			continue;
+		}
+
+		size_t probe = ((i - (slots[i].hash & mask)) & mask) + 1;
+
+		if (probe > stats->max_probe)
+			stats->max_probe = probe;
+
+		if (++cluster > stats->max_cluster)
+			stats->max_cluster = cluster;
+
+		probes += probe;
+		++stats->used_slots;
+	}
+
+	stats->load_factor = (double)stats->used_slots / (double)slotCount;
+
+	if (stats->used_slots)
+		stats->average_probe = (double)probes / (double)stats->used_slots;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: get occupancy of indices of hash table
+//-----------------------------------------------------------------------------
+
+void ini_get_table_stats(const struct ini_data *data, struct ini_table_stats *stats)
+{
+	ini_index_stats(data->slots, data->slot_count, &stats->entries);
+	ini_index_stats(data->section_slots, data->section_slot_count, &stats->sections);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: free allocated memory from hash table
+//-----------------------------------------------------------------------------
+
+void ini_free_data(struct ini_data *data, int is_allocated)
+{
+	free(data->entries);
+	free(data->sections);
+
+	// Indices of snapshot are inside of the mapping
+	if (!data->snapshot)
+	{
+		free(data->slots);
+		free(data->section_slots);
+	}
+
+	// Strings and sections live in the arena
+	ini_arena_free(&data->arena);
+
+	ini_lazy_free((ini_lazy_t *)data->lazy);
+
+	ini_unmap_file(data->mapping, data->mapping_size);
+
+	if (is_allocated)
+		free(data);
+	else
+		memset(data, 0, sizeof(struct ini_data));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: align offset in snapshot to 8 bytes
+//-----------------------------------------------------------------------------
+
+static inline unsigned long long ini_snapshot_align(unsigned long long offset)
+{
+	return (offset + 7) & ~7ULL;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: save filled hash table to binary snapshot
+//-----------------------------------------------------------------------------
+
+int ini_save_snapshot(const struct ini_data *data, const char *filename)
+{
+	if (!ini_load_sections((struct ini_data *)data))
+		return 0;
+
+	ini_snapshot_header_t header;
+
+	memset(&header, 0, sizeof(header));
+
+	header.magic = INI_SNAPSHOT_MAGIC;
+	header.version = INI_SNAPSHOT_VERSION;
+	header.byte_order = INI_SNAPSHOT_BYTE_ORDER;
+
+	header.slot_count = data->slots ? data->slot_count : 0;
+	header.section_slot_count = data->section_slots ? data->section_slot_count : 0;
+	header.section_count = data->section_count;
+	header.entry_count = data->entry_count;
+
+	header.strings_size = 0;
+
+	for (size_t i = 0; i < data->section_count; ++i)
+		header.strings_size += data->sections[i]->length + 1;
+
+	for (size_t i = 0; i < data->entry_count; ++i)
+		header.strings_size += data->entries[i].key_length + data->entries[i].value_length + 2;
+
+	header.slots = ini_snapshot_align(sizeof(header));
+	header.section_slots = header.slots + header.slot_count * sizeof(struct ini_slot);
+	header.sections = ini_snapshot_align(header.section_slots + header.section_slot_count * sizeof(struct ini_slot));
+	header.entries = header.sections + header.section_count * sizeof(ini_snapshot_section_t);
+	header.strings = header.entries + header.entry_count * sizeof(ini_snapshot_entry_t);
+	header.size = header.strings + header.strings_size;
+
+	if (header.size > (size_t)-1)
+		return ini_default_result(INI_ERROR_WRITE_FILE);
+
+	char *image = calloc(1, (size_t)header.size);
+
+	if (!image)
+		return ini_default_result(INI_ERROR_OUT_OF_MEMORY);
+
+	// Slots keep the same positions, so no need to rehash
+	if (header.slot_count)
+		memcpy(image + header.slots, data->slots, header.slot_count * sizeof(struct ini_slot));
+
+	if (header.section_slot_count)
+		memcpy(image + header.section_slots, data->section_slots, header.section_slot_count * sizeof(struct ini_slot));
+
+	ini_snapshot_section_t *sections = (ini_snapshot_section_t *)(image + header.sections);
+	ini_snapshot_entry_t *entries = (ini_snapshot_entry_t *)(image + header.entries);
+
+	unsigned long long position = header.strings;
+
+	for (size_t i = 0; i < data->section_count; ++i)
+	{
+		const struct ini_section *section = data->sections[i];
+
+		sections[i].name = position;
+		sections[i].length = section->length;
+		sections[i].hash = section->hash;
+
+		// Calloc'ed image is already terminated
+		memcpy(image + position, section->name, section->length);
+		position += section->length + 1;
+	}
+
+	for (size_t i = 0; i < data->entry_count; ++i)
+	{
+		const struct ini_entry *entry = &data->entries[i];
+
+		size_t j = entry->section->index;
+
+		entries[i].key = position;
+		entries[i].key_length = entry->key_length;
+
+		memcpy(image + position, entry->key, entry->key_length);
+		position += entry->key_length + 1;
+
+		entries[i].value = position;
+		entries[i].value_length = entry->value_length;
+
+		memcpy(image + position, entry->value, entry->value_length);
+		position += entry->value_length + 1;
+
+		entries[i].section = (unsigned int)j;
+		entries[i].hash = entry->hash;
+	}
+
+	header.checksum = ini_hash(image + sizeof(header), (size_t)header.size - sizeof(header), 0);
+	memcpy(image, &header, sizeof(header));
+
+	FILE *file = fopen(filename, "wb");
+	int success = 0;
+
+	if (file)
+	{
+		success = fwrite(image, 1, (size_t)header.size, file) == header.size;
+		success = (fclose(file) == 0) && success;
+	}
+
+	free(image);
+
+	return ini_default_result(success ? INI_NO_ERROR : INI_ERROR_WRITE_FILE);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: check that range of table lies inside of snapshot
+//-----------------------------------------------------------------------------
+
+static int ini_snapshot_range(const ini_snapshot_header_t *header, unsigned long long offset, unsigned long long count, size_t size)
+{
+	if ((offset & 7) || offset < sizeof(ini_snapshot_header_t) || offset > header->size)
+		return 0;
+
+	return count <= (header->size - offset) / size;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: check that string of snapshot is inside of table of strings
+//-----------------------------------------------------------------------------
+
+static int ini_snapshot_string(const ini_snapshot_header_t *header, const char *image, unsigned long long offset, unsigned long long length)
+{
+	unsigned long long end = header->strings + header->strings_size;
+
+	if (offset < header->strings || offset >= end || length >= end - offset)
+		return 0;
+
+	return image[offset + length] == '\0';
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: check that index of open addressing is valid for count of elements:
+// every element is indexed exactly once, so at least one slot is empty and
+// probing always ends
+// Return value: INI_NO_ERROR, INI_ERROR_INVALID_SNAPSHOT or INI_ERROR_OUT_OF_MEMORY
+//-----------------------------------------------------------------------------
+
+static int ini_snapshot_slots(const struct ini_slot *slots, unsigned long long slotCount, unsigned long long count)
+{
+	// Empty table has no index
+	if (!slotCount)
+		return (count == 0) ? INI_NO_ERROR : INI_ERROR_INVALID_SNAPSHOT;
+
+	if ((slotCount & (slotCount - 1)) || count >= slotCount)
+		return INI_ERROR_INVALID_SNAPSHOT;
+
+	unsigned char *seen = calloc((size_t)count / 8 + 1, 1);
+
+	if (!seen)
+		return INI_ERROR_OUT_OF_MEMORY;
+
+	unsigned long long used = 0;
+	int error = INI_NO_ERROR;
+
+	for (unsigned long long i = 0; i < slotCount; ++i)
+	{
+		unsigned int index = slots[i].index;
+
+		if (!index)
+			continue;
+
+		if (index > count || (seen[(index - 1) / 8] & (1u << ((index - 1) % 8))))
+		{
+			error = INI_ERROR_INVALID_SNAPSHOT;
+			break;
+		}
+
+		seen[(index - 1) / 8] |= (unsigned char)(1u << ((index - 1) % 8));
+		++used;
+	}
+
+	free(seen);
+
+	// Probing ends on empty slot
+	if (error == INI_NO_ERROR && used != count)
+		error = INI_ERROR_INVALID_SNAPSHOT;
+
+	return error;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: load binary snapshot of hash table by mapping it in memory
+//-----------------------------------------------------------------------------
+
+int ini_load_snapshot(const char *filename, struct ini_data *data)
+{
+	void *mapping;
+	size_t size;
+
+	memset(data, 0, sizeof(struct ini_data));
+
+	if (!ini_map_file(filename, &mapping, &size))
+		return ini_missing_file(&s_default_parser);
+
+	const char *image = (const char *)mapping;
+	ini_snapshot_header_t header;
+
+	if (size < sizeof(header))
+	{
+		ini_unmap_file(mapping, size);
+		return ini_default_result(INI_ERROR_INVALID_SNAPSHOT);
+	}
+
+	memcpy(&header, image, sizeof(header));
+
+	int valid = header.magic == INI_SNAPSHOT_MAGIC &&
+		header.version == INI_SNAPSHOT_VERSION &&
+		header.byte_order == INI_SNAPSHOT_BYTE_ORDER &&
+		header.size == size &&
+		ini_snapshot_range(&header, header.slots, header.slot_count, sizeof(struct ini_slot)) &&
+		ini_snapshot_range(&header, header.section_slots, header.section_slot_count, sizeof(struct ini_slot)) &&
+		ini_snapshot_range(&header, header.sections, header.section_count, sizeof(ini_snapshot_section_t)) &&
+		ini_snapshot_range(&header, header.entries, header.entry_count, sizeof(ini_snapshot_entry_t)) &&
+		ini_snapshot_range(&header, header.strings, header.strings_size, 1) &&
+		header.checksum == ini_hash(image + sizeof(header), size - sizeof(header), 0);
+
+	int error = valid ? INI_NO_ERROR : INI_ERROR_INVALID_SNAPSHOT;
+
+	if (error == INI_NO_ERROR)
+		error = ini_snapshot_slots((const struct ini_slot *)(image + header.slots), header.slot_count, header.entry_count);
+
+	if (error == INI_NO_ERROR)
+		error = ini_snapshot_slots((const struct ini_slot *)(image + header.section_slots), header.section_slot_count, header.section_count);
+
+	if (error != INI_NO_ERROR)
+	{
+		ini_unmap_file(mapping, size);
+		return ini_default_result(error);
+	}
+
+	data->mapping = mapping;
+	data->mapping_size = size;
+	data->snapshot = 1;
+	data->generation = ini_next_generation();
+
+	// Indices are used in place
+	data->slots = (struct ini_slot *)(image + header.slots);
+	data->slot_count = (size_t)header.slot_count;
+	data->section_slots = (struct ini_slot *)(image + header.section_slots);
+	data->section_slot_count = (size_t)header.section_slot_count;
+
+	if (!header.slot_count)
+		data->slots = NULL;
+
+	if (!header.section_slot_count)
+		data->section_slots = NULL;
+
+	// One block per table, strings point into the mapping
+	struct ini_section *sections = header.section_count ? ini_arena_alloc(&data->arena, (size_t)header.section_count * sizeof(struct ini_section), INI_ARENA_ALIGNMENT) : NULL;
+
+	data->sections = header.section_count ? malloc((size_t)header.section_count * sizeof(struct ini_section *)) : NULL;
+	data->entries = header.entry_count ? malloc((size_t)header.entry_count * sizeof(struct ini_entry)) : NULL;
+
+	if ((header.section_count && (!sections || !data->sections)) || (header.entry_count && !data->entries))
+	{
+		error = INI_ERROR_OUT_OF_MEMORY;
+		valid = 0;
+	}
+
+	const ini_snapshot_section_t *snapshotSections = (const ini_snapshot_section_t *)(image + header.sections);
+	const ini_snapshot_entry_t *snapshotEntries = (const ini_snapshot_entry_t *)(image + header.entries);
+
+	for (size_t i = 0; valid && i < header.section_count; ++i)
+	{
+		if (!ini_snapshot_string(&header, image, snapshotSections[i].name, snapshotSections[i].length))
+		{
+			valid = 0;
+			break;
+		}
+
+		sections[i].name = image + snapshotSections[i].name;
+		sections[i].length = (size_t)snapshotSections[i].length;
+		sections[i].hash = snapshotSections[i].hash;
+		sections[i].index = i;
+
+		data->sections[i] = &sections[i];
+	}
+
+	for (size_t i = 0; valid && i < header.entry_count; ++i)
+	{
+		const ini_snapshot_entry_t *record = &snapshotEntries[i];
+
+		if (record->section >= header.section_count ||
+			!ini_snapshot_string(&header, image, record->key, record->key_length) ||
+			!ini_snapshot_string(&header, image, record->value, record->value_length))
+		{
+			valid = 0;
+			break;
+		}
+
+		struct ini_entry *entry = &data->entries[i];
+
+		entry->key = image + record->key;
+		entry->value = image + record->value;
+		entry->section = &sections[record->section];
+		entry->key_length = (size_t)record->key_length;
+		entry->value_length = (size_t)record->value_length;
+		entry->hash = record->hash;
+		entry->cache_state = INI_CACHE_EMPTY;
+		entry->cache = 0;
+	}
+
+	data->section_count = data->section_capacity = (size_t)header.section_count;
+	data->entry_count = data->entry_capacity = (size_t)header.entry_count;
+
+	// Index is in the mapping, so entries can't be moved
+	if (valid && !ini_index_sections(data, 0))
+		valid = 0;
+
+	if (!valid)
+	{
+		ini_free_data(data, 0);
+		return ini_default_result((error == INI_NO_ERROR) ? INI_ERROR_INVALID_SNAPSHOT : error);
+	}
+
+	return ini_default_result(INI_NO_ERROR);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: let other threads run while waiting for readers
+//-----------------------------------------------------------------------------
+
+static void ini_yield()
+{
+#ifdef _WIN32
+	SwitchToThread();
+#else
+	sched_yield();
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: get time of modification and size of file (0 - missing file)
+//-----------------------------------------------------------------------------
+
+static unsigned long long ini_file_stamp(const char *filename)
+{
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+
+	if (!GetFileAttributesExA(filename, GetFileExInfoStandard, &attributes))
+		return 0;
+
+	return (((unsigned long long)attributes.ftLastWriteTime.dwHighDateTime << 32) | attributes.ftLastWriteTime.dwLowDateTime) ^
+		((unsigned long long)attributes.nFileSizeLow * 0x9E3779B97F4A7C15ULL);
+#else
+	struct stat st;
+
+	if (stat(filename, &st) == -1)
+		return 0;
+
+	return ((unsigned long long)st.st_mtime * 1000000007ULL) ^ ((unsigned long long)st.st_size * 0x9E3779B97F4A7C15ULL) ^ (unsigned long long)st.st_ino;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: compare tables and report added, removed and modified parameters
+//-----------------------------------------------------------------------------
+
+static void ini_report_changes(struct ini_reloader *reloader, const struct ini_data *previous, const struct ini_data *current)
+{
+	for (size_t i = 0; i < current->entry_count; ++i)
+	{
+		const struct ini_entry *entry = &current->entries[i];
+		const struct ini_entry *previousEntry = NULL;
+
+		if (previous)
+		{
+			const struct ini_section *section = ini_find_section(previous, entry->section->name, entry->section->length, entry->section->hash);
+
+			if (section)
+				previousEntry = ini_find_entry(previous, section, entry->key, entry->key_length, entry->hash);
+		}
+
+		if (!previousEntry)
+			reloader->on_change(reloader->context, INI_CHANGE_ADDED, NULL, entry);
+		else if (previousEntry->value_length != entry->value_length || memcmp(previousEntry->value, entry->value, entry->value_length))
+			reloader->on_change(reloader->context, INI_CHANGE_MODIFIED, previousEntry, entry);
+	}
+
+	for (size_t i = 0; previous && i < previous->entry_count; ++i)
+	{
+		const struct ini_entry *entry = &previous->entries[i];
+		const struct ini_section *section = ini_find_section(current, entry->section->name, entry->section->length, entry->section->hash);
+
+		if (!section || !ini_find_entry(current, section, entry->key, entry->key_length, entry->hash))
+			reloader->on_change(reloader->context, INI_CHANGE_REMOVED, entry, NULL);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: initialize reloader of .ini file
+//-----------------------------------------------------------------------------
+
+int ini_reloader_init(struct ini_reloader *reloader, const char *filename, int options)
+{
+	memset(reloader, 0, sizeof(struct ini_reloader));
+
+	ini_watcher_t *watcher = calloc(1, sizeof(ini_watcher_t));
+	size_t length = strlen(filename);
+
+	reloader->filename = malloc(length + 1);
+
+	if (!watcher || !reloader->filename)
+	{
+		free(watcher);
+		free(reloader->filename);
+
+		reloader->filename = NULL;
+		return 0;
+	}
+
+	memcpy(reloader->filename, filename, length + 1);
+
+#ifdef _WIN32
+	InitializeCriticalSection(&watcher->lock);
+#else
+	pthread_mutex_init(&watcher->lock, NULL);
+#endif
+
+	reloader->watcher = watcher;
+	ini_parser_init(&reloader->parser, options);
+
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: set function called after reload
+//-----------------------------------------------------------------------------
+
+void ini_reloader_set_callback(struct ini_reloader *reloader, iniChangeFn callback, void *context)
+{
+	reloader->on_change = callback;
+	reloader->context = context;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: parse file into a new table and publish it
+//-----------------------------------------------------------------------------
+
+int ini_reloader_reload(struct ini_reloader *reloader)
+{
+	ini_watcher_t *watcher = (ini_watcher_t *)reloader->watcher;
+
+#ifdef _WIN32
+	EnterCriticalSection(&watcher->lock);
+#else
+	pthread_mutex_lock(&watcher->lock);
+#endif
+
+	struct ini_data *data = malloc(sizeof(struct ini_data));
+	int success = (data != NULL);
+
+	// Readers keep using the current table meanwhile
+	if (success && !ini_parser_parse_data(&reloader->parser, reloader->filename, data))
+	{
+		free(data);
+		success = 0;
+	}
+
+	// Changes are found in all sections, lazily parsed table is parsed whole
+	if (success && reloader->on_change && !ini_load_sections(data))
+	{
+		ini_free_data(data, 1);
+		success = 0;
+	}
+
+	if (success)
+	{
+		struct ini_data *previous = INI_ATOMIC_EXCHANGE_POINTER(&reloader->current, data);
+
+		// New readers are counted in the other slot, wait for the ones which could see previous table
+		unsigned int epoch = INI_ATOMIC_ADD(&reloader->epoch, 1) - 1;
+
+		while (INI_ATOMIC_LOAD(&reloader->readers[epoch & 1]))
+			ini_yield();
+
+		if (reloader->on_change)
+			ini_report_changes(reloader, previous, data);
+
+		if (previous)
+			ini_free_data(previous, 1);
+	}
+	else if (reloader->on_change)
+	{
+		reloader->on_change(reloader->context, INI_CHANGE_FAILED, NULL, NULL);
+	}
+
+#ifdef _WIN32
+	LeaveCriticalSection(&watcher->lock);
+#else
+	pthread_mutex_unlock(&watcher->lock);
+#endif
+
+	return success;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: get current table and enter epoch of reading
+//-----------------------------------------------------------------------------
+
+struct ini_data *ini_reloader_acquire(struct ini_reloader *reloader, unsigned int *ticket)
+{
+	for (;;)
+	{
+		unsigned int epoch = INI_ATOMIC_LOAD(&reloader->epoch);
+
+		INI_ATOMIC_ADD(&reloader->readers[epoch & 1], 1);
+
+		// Epoch didn't change, so reloader waits for us
+		if (INI_ATOMIC_LOAD(&reloader->epoch) == epoch)
+		{
+			struct ini_data *data = (struct ini_data *)INI_ATOMIC_LOAD_POINTER(&reloader->current);
+
+			if (data)
+			{
+				*ticket = epoch & 1;
+				return data;
+			}
+
+			// Nothing to read, reader isn't counted, so forgotten release can't block reloading
+			INI_ATOMIC_ADD(&reloader->readers[epoch & 1], (unsigned int)-1);
+			*ticket = INI_RELOAD_NO_TICKET;
+
+			return NULL;
+		}
+
+		INI_ATOMIC_ADD(&reloader->readers[epoch & 1], (unsigned int)-1);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: leave epoch of reading
+//-----------------------------------------------------------------------------
+
+void ini_reloader_release(struct ini_reloader *reloader, unsigned int ticket)
+{
+	if (ticket == INI_RELOAD_NO_TICKET)
+		return;
+
+	INI_ATOMIC_ADD(&reloader->readers[ticket], (unsigned int)-1);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: reload file when it's changed until watching is stopped
+//-----------------------------------------------------------------------------
+
+#ifdef _WIN32
+static DWORD WINAPI ini_watch_thread(LPVOID parameter)
+#else
+static void *ini_watch_thread(void *parameter)
+#endif
+{
+	struct ini_reloader *reloader = (struct ini_reloader *)parameter;
+	ini_watcher_t *watcher = (ini_watcher_t *)reloader->watcher;
+
+	// Watch directory, editors often replace file by renaming
+	const char *filename = reloader->filename;
+	const char *name = filename;
+
+	for (const char *str = filename; *str; ++str)
+	{
+		if (*str == '/' || *str == '\\')
+			name = str + 1;
+	}
+
+	char *directory = malloc(name - filename + 2);
+
+	if (!directory)
+		return 0;
+
+	if (name == filename)
+	{
+		strcpy(directory, ".");
+	}
+	else
+	{
+		memcpy(directory, filename, name - filename);
+		directory[name - filename] = '\0';
+	}
+
+	unsigned long long stamp = ini_file_stamp(filename);
+
+#ifdef _WIN32
+	HANDLE hChange = FindFirstChangeNotificationA(directory, FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE);
+	HANDLE handles[2] = { watcher->stopEvent, hChange };
+
+	for (;;)
+	{
+		DWORD result = (hChange != INVALID_HANDLE_VALUE) ?
+			WaitForMultipleObjects(2, handles, FALSE, INFINITE) :
+			WaitForSingleObject(watcher->stopEvent, INI_RELOAD_POLL_INTERVAL);
+
+		if (result == WAIT_OBJECT_0)
+			break;
+
+		if (hChange != INVALID_HANDLE_VALUE && !FindNextChangeNotification(hChange))
+			break;
+
+		// Notifications are per directory
+		unsigned long long newStamp = ini_file_stamp(filename);
+
+		if (newStamp && newStamp != stamp)
+		{
+			stamp = newStamp;
+			ini_reloader_reload(reloader);
+		}
+	}
+
+	if (hChange != INVALID_HANDLE_VALUE)
+		FindCloseChangeNotification(hChange);
+#else
+	int fd = -1;
+
+#ifdef __linux__
+	fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+	if (fd != -1 && inotify_add_watch(fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO) == -1)
+	{
+		close(fd);
+		fd = -1;
+	}
+#endif
+
+	struct pollfd fds[2];
+
+	fds[0].fd = watcher->stopPipe[0];
+	fds[0].events = POLLIN;
+	fds[1].fd = fd;
+	fds[1].events = POLLIN;
+
+	for (;;)
+	{
+		// Without notifications check time of modification periodically
+		int result = poll(fds, (fd != -1) ? 2 : 1, (fd != -1) ? -1 : INI_RELOAD_POLL_INTERVAL);
+
+		if (result == -1 && errno == EINTR)
+			continue;
+
+		if (result == -1 || (fds[0].revents & POLLIN))
+			break;
+
+		int isChanged = 0;
+
+#ifdef __linux__
+		if (fd != -1)
+		{
+			char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+			ssize_t length;
+
+			while ((length = read(fd, events, sizeof(events))) > 0)
+			{
+				for (char *event = events; event < events + length; event += sizeof(struct inotify_event) + ((struct inotify_event *)event)->len)
+				{
+					const struct inotify_event *notification = (const struct inotify_event *)event;
+
+					if (notification->len && !strcmp(notification->name, name))
+						isChanged = 1;
+				}
+			}
+		}
+		else
+#endif
+		{
+			unsigned long long newStamp = ini_file_stamp(filename);
+
+			if (newStamp && newStamp != stamp)
+			{
+				stamp = newStamp;
+				isChanged = 1;
+			}
+		}
+
+		if (isChanged)
+			ini_reloader_reload(reloader);
+	}
+
+	if (fd != -1)
+		close(fd);
+#endif
+
+	free(directory);
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: start watching file in background thread
+//-----------------------------------------------------------------------------
+
+int ini_reloader_watch(struct ini_reloader *reloader)
+{
+	ini_watcher_t *watcher = (ini_watcher_t *)reloader->watcher;
+
+	if (watcher->isWatching)
+		return 1;
+
+#ifdef _WIN32
+	watcher->stopEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+
+	if (!watcher->stopEvent)
+		return 0;
+
+	watcher->thread = CreateThread(NULL, 0, ini_watch_thread, reloader, 0, NULL);
+
+	if (!watcher->thread)
+	{
+		CloseHandle(watcher->stopEvent);
+		return 0;
+	}
+#else
+	if (pipe(watcher->stopPipe) == -1)
+		return 0;
+
+	if (pthread_create(&watcher->thread, NULL, ini_watch_thread, reloader) != 0)
+	{
+		close(watcher->stopPipe[0]);
+		close(watcher->stopPipe[1]);
+		return 0;
+	}
+#endif
+
+	watcher->isWatching = 1;
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: stop watching and free current table of reloader
+//-----------------------------------------------------------------------------
+
+void ini_reloader_free(struct ini_reloader *reloader)
+{
+	ini_watcher_t *watcher = (ini_watcher_t *)reloader->watcher;
+
+	if (!watcher)
+		return;
+
+	if (watcher->isWatching)
+	{
+#ifdef _WIN32
+		SetEvent(watcher->stopEvent);
+		WaitForSingleObject(watcher->thread, INFINITE);
+
+		CloseHandle(watcher->thread);
+		CloseHandle(watcher->stopEvent);
+#else
+		char stop = 1;
+
+		while (write(watcher->stopPipe[1], &stop, 1) == -1 && errno == EINTR)
+			;
+
+		pthread_join(watcher->thread, NULL);
+
+		close(watcher->stopPipe[0]);
+		close(watcher->stopPipe[1]);
+#endif
+	}
+
+#ifdef _WIN32
+	DeleteCriticalSection(&watcher->lock);
+#else
+	pthread_mutex_destroy(&watcher->lock);
+#endif
+
+	if (reloader->current)
+		ini_free_data(reloader->current, 1);
+
+	ini_parser_free(&reloader->parser);
+
+	free(reloader->filename);
+	free(watcher);
+
+	memset(reloader, 0, sizeof(struct ini_reloader));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: write buffer of writer to file
+//-----------------------------------------------------------------------------
+
+static int ini_writer_flush(struct ini_writer *writer)
+{
+	if (writer->used && fwrite(writer->buffer, 1, writer->used, writer->file) != writer->used)
+		writer->error_code = INI_ERROR_WRITE_FILE;
+
+	writer->used = 0;
+
+	return writer->error_code == INI_NO_ERROR;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: append text to buffer of writer, large blocks are written directly
+//-----------------------------------------------------------------------------
+
+static int ini_writer_put(struct ini_writer *writer, const char *str, size_t length)
+{
+	if (writer->error_code != INI_NO_ERROR)
+		return 0;
+
+	if (!length)
+		return 1;
+
+	if (writer->used + length > INI_WRITER_BUFFER_SIZE)
+	{
+		if (!ini_writer_flush(writer))
+			return 0;
+
+		if (length >= INI_WRITER_BUFFER_SIZE)
+		{
+			if (fwrite(str, 1, length, writer->file) != length)
+				writer->error_code = INI_ERROR_WRITE_FILE;
+
+			return writer->error_code == INI_NO_ERROR;
+		}
+	}
+
+	memcpy(writer->buffer + writer->used, str, length);
+	writer->used += length;
+
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: check that string is read back the same (not empty, not stripped,
+// no comments, newlines and delimiters of parameters)
+//-----------------------------------------------------------------------------
+
+static int ini_is_writable(const char *str, size_t length, string_type_t type)
+{
+	if (!length)
+		return 0;
+
+	if (ini_contains_chars(str[0], INI_STRIP_CHARS, INI_STRIP_CHARS_LEN) || ini_contains_chars(str[length - 1], INI_STRIP_CHARS, INI_STRIP_CHARS_LEN))
+		return 0;
+
+	// Key at start of line which looks like section
+	if (type == STRING_KEY && str[0] == INI_SECTION_PREFIX)
+		return 0;
+
+	for (size_t i = 0; i < length; ++i)
+	{
+		if (str[i] == '\n' || ini_contains_chars(str[i], INI_COMMENT_PREFIX, INI_COMMENT_PREFIX_LEN))
+			return 0;
+
+		if (type != STRING_SECTION && str[i] == INI_PARAMETER_DELIMITER_CHAR)
+			return 0;
+	}
+
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: write header of section
+//-----------------------------------------------------------------------------
+
+static int ini_writer_section(struct ini_writer *writer, const char *section, size_t length)
+{
+	if (!ini_is_writable(section, length, STRING_SECTION))
+	{
+		writer->error_code = INI_ERROR_INVALID_STRING;
+		return 0;
+	}
+
+	if (!ini_reserve(&writer->section, &writer->section_size, length + 1))
+	{
+		writer->error_code = INI_ERROR_OUT_OF_MEMORY;
+		return 0;
+	}
+
+	memcpy(writer->section, section, length);
+	writer->section[length] = '\0';
+	writer->section_length = length;
+
+	// Empty line between sections
+	if (writer->is_written && !ini_writer_put(writer, "\n", 1))
+		return 0;
+
+	writer->is_written = 1;
+
+	return ini_writer_put(writer, "[", 1) && ini_writer_put(writer, section, length) && ini_writer_put(writer, "]\n", 2);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: write line of parameter
+//-----------------------------------------------------------------------------
+
+static int ini_writer_parameter(struct ini_writer *writer, const char *key, size_t keyLength, const char *value, size_t valueLength)
+{
+	if (!ini_is_writable(key, keyLength, STRING_KEY) || !ini_is_writable(value, valueLength, STRING_VALUE))
+	{
+		writer->error_code = INI_ERROR_INVALID_STRING;
+		return 0;
+	}
+
+	return ini_writer_put(writer, key, keyLength) && ini_writer_put(writer, " = ", 3) &&
+		ini_writer_put(writer, value, valueLength) && ini_writer_put(writer, "\n", 1);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: allocate buffer of writer, file is attached after it
+//-----------------------------------------------------------------------------
+
+static int ini_writer_init(struct ini_writer *writer)
+{
+	memset(writer, 0, sizeof(struct ini_writer));
+
+	writer->error_code = INI_NO_ERROR;
+	writer->buffer = malloc(INI_WRITER_BUFFER_SIZE);
+
+	if (!writer->buffer)
+		return ini_default_result(INI_ERROR_OUT_OF_MEMORY);
+
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: open file to write
+//-----------------------------------------------------------------------------
+
+int ini_writer_open(struct ini_writer *writer, const char *filename)
+{
+	if (!ini_writer_init(writer))
+		return 0;
+
+	writer->file = fopen(filename, "wb");
+
+	if (!writer->file)
+	{
+		free(writer->buffer);
+		writer->buffer = NULL;
+
+		return ini_missing_file(&s_default_parser);
+	}
+
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: write parameter, header is written when section changes
+//-----------------------------------------------------------------------------
+
+int ini_writer_write(struct ini_writer *writer, const char *section, const char *key, const char *value)
+{
+	size_t length = strlen(section);
+
+	if (!writer->section || writer->section_length != length || memcmp(writer->section, section, length))
+	{
+		if (!ini_writer_section(writer, section, length))
+			return ini_default_result(writer->error_code);
+	}
+
+	if (!ini_writer_parameter(writer, key, strlen(key), value, strlen(value)))
+		return ini_default_result(writer->error_code);
+
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: flush buffer and close file
+//-----------------------------------------------------------------------------
+
+int ini_writer_close(struct ini_writer *writer)
+{
+	if (!writer->file)
+		return 0;
+
+	ini_writer_flush(writer);
+
+	if (fclose(writer->file) != 0 && writer->error_code == INI_NO_ERROR)
+		writer->error_code = INI_ERROR_WRITE_FILE;
+
+	int error = writer->error_code;
+
+	free(writer->buffer);
+	free(writer->section);
+
+	memset(writer, 0, sizeof(struct ini_writer));
+
+	return ini_default_result(error);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: get path of file which is replaced instead of the given one, links
+// are followed, the last of them may point to file which doesn't exist yet
+//-----------------------------------------------------------------------------
+
+static char *ini_resolve_links(const char *filename)
+{
+	size_t length = strlen(filename);
+	char *path = malloc(length + 1);
+
+	if (!path)
+	{
+		ini_default_result(INI_ERROR_OUT_OF_MEMORY);
+		return NULL;
+	}
+
+	memcpy(path, filename, length + 1);
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename, 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+
+	// Missing file is created by its name
+	if (file == INVALID_HANDLE_VALUE)
+		return path;
+
+	DWORD finalLength = GetFinalPathNameByHandleA(file, NULL, 0, FILE_NAME_NORMALIZED);
+	char *finalPath = finalLength ? malloc(finalLength) : NULL;
+
+	if (finalPath && GetFinalPathNameByHandleA(file, finalPath, finalLength, FILE_NAME_NORMALIZED) < finalLength)
+	{
+		// Drop prefix of long paths, "\\?\C:\dir" becomes "C:\dir" and "\\?\UNC\host" becomes "\\host"
+		const char *start = finalPath;
+		size_t offset = 0;
+
+		if (!strncmp(finalPath, "\\\\?\\UNC\\", 8))
+		{
+			start += 6;
+			offset = 1;
+		}
+		else if (!strncmp(finalPath, "\\\\?\\", 4))
+		{
+			start += 4;
+		}
+
+		free(path);
+		path = finalPath;
+
+		memmove(path + offset, start, strlen(start) + 1);
+
+		if (offset)
+			path[0] = '\\';
+
+		finalPath = NULL;
+	}
+	else if (!finalPath && finalLength)
+	{
+		free(path);
+		path = NULL;
+
+		ini_default_result(INI_ERROR_OUT_OF_MEMORY);
+	}
+
+	free(finalPath);
+	CloseHandle(file);
+
+	return path;
+#else
+	for (int depth = 0; depth < 40; ++depth)
+	{
+		struct stat st;
+
+		if (lstat(path, &st) != 0 || !S_ISLNK(st.st_mode))
+			return path;
+
+		// Size of link is zero in some file systems
+		size_t size = (st.st_size > 0 ? (size_t)st.st_size : 4096) + 1;
+		char *link = malloc(size);
+
+		if (!link)
+		{
+			free(path);
+			ini_default_result(INI_ERROR_OUT_OF_MEMORY);
+			return NULL;
+		}
+
+		ssize_t linkLength = readlink(path, link, size);
+
+		// Link changed while it was read
+		if (linkLength < 0 || (size_t)linkLength >= size)
+		{
+			free(link);
+			free(path);
+			ini_default_result(INI_ERROR_WRITE_FILE);
+			return NULL;
+		}
+
+		// Relative link starts in directory of link
+		const char *slash = strrchr(path, '/');
+		size_t directoryLength = (link[0] != '/' && slash) ? (size_t)(slash - path) + 1 : 0;
+		char *next = malloc(directoryLength + (size_t)linkLength + 1);
+
+		if (next)
+		{
+			memcpy(next, path, directoryLength);
+			memcpy(next + directoryLength, link, (size_t)linkLength);
+			next[directoryLength + (size_t)linkLength] = '\0';
+		}
+		else
+		{
+			ini_default_result(INI_ERROR_OUT_OF_MEMORY);
+		}
+
+		free(link);
+		free(path);
+
+		if (!(path = next))
+			return NULL;
+	}
+
+	// Loop of links
+	free(path);
+	ini_default_result(INI_ERROR_WRITE_FILE);
+
+	return NULL;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: create temporary file with unique name in directory of the file it
+// replaces, temporary file gets mode (attributes on Windows) of replaced file
+//-----------------------------------------------------------------------------
+
+static FILE *ini_create_temporary(const char *filename, char **target, char **temporary)
+{
+	*temporary = NULL;
+
+	if (!(*target = ini_resolve_links(filename)))
+		return NULL;
+
+	FILE *file = NULL;
+
+#ifdef _WIN32
+	size_t length = strlen(*target);
+	char *directory = malloc(length + 2);
+
+	*temporary = malloc(MAX_PATH);
+
+	if (!directory || !*temporary)
+	{
+		free(directory);
+		ini_default_result(INI_ERROR_OUT_OF_MEMORY);
+	}
+	else
+	{
+		size_t directoryLength = length;
+
+		while (directoryLength > 0 && (*target)[directoryLength - 1] != '\\' && (*target)[directoryLength - 1] != '/' && (*target)[directoryLength - 1] != ':')
+			--directoryLength;
+
+		if (directoryLength)
+			memcpy(directory, *target, directoryLength);
+		else
+			directory[directoryLength++] = '.';
+
+		directory[directoryLength] = '\0';
+
+		// File is created with unique name, so it belongs to this call only
+		if (GetTempFileNameA(directory, "ini", 0, *temporary))
+		{
+			DWORD attributes = GetFileAttributesA(*target);
+
+			file = fopen(*temporary, "wb");
+
+			if (!file)
+				remove(*temporary);
+			else if (attributes != INVALID_FILE_ATTRIBUTES)
+				SetFileAttributesA(*temporary, attributes & (FILE_ATTRIBUTE_HIDDEN | FILE_ATTRIBUTE_SYSTEM | FILE_ATTRIBUTE_ARCHIVE | FILE_ATTRIBUTE_NOT_CONTENT_INDEXED));
+		}
+
+		free(directory);
+
+		if (!file)
+			ini_default_result(INI_ERROR_WRITE_FILE);
+	}
+#else
+	// Name is "<file>.<random>.tmp"
+	size_t length = strlen(*target);
+	*temporary = malloc(length + 14);
+
+	if (!*temporary)
+	{
+		ini_default_result(INI_ERROR_OUT_OF_MEMORY);
+	}
+	else
+	{
+		struct stat st;
+		int exists = (stat(*target, &st) == 0);
+		mode_t mode = exists ? (st.st_mode & 07777) : 0666;
+
+		unsigned long long seed[3] = { (unsigned long long)getpid(), (unsigned long long)time(NULL), INI_ATOMIC_INCREMENT(&s_last_temporary) };
+		int fd = -1;
+
+		// Exclusive creation fails when file exists, so the file belongs to this call only
+		for (unsigned int attempt = 0; fd == -1 && attempt < 64; ++attempt)
+		{
+			memcpy(*temporary, *target, length);
+			sprintf(*temporary + length, ".%08x.tmp", ini_hash((const char *)seed, sizeof(seed), attempt));
+
+			fd = open(*temporary, O_WRONLY | O_CREAT | O_EXCL, mode);
+
+			if (fd == -1 && errno != EEXIST)
+				break;
+		}
+
+		if (fd != -1)
+		{
+			// Mode given to open is masked by umask, replaced file keeps its mode
+			if ((!exists || fchmod(fd, mode) == 0) && (file = fdopen(fd, "wb")))
+				fd = -1;
+
+			if (fd != -1)
+			{
+				close(fd);
+				remove(*temporary);
+			}
+		}
+
+		if (!file)
+			ini_default_result(INI_ERROR_WRITE_FILE);
+	}
+#endif
+
+	if (!file)
+	{
+		free(*target);
+		free(*temporary);
+
+		*target = NULL;
+		*temporary = NULL;
+	}
+
+	return file;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: replace file by written temporary file at once or remove temporary
+// file when writing failed, names of both files are freed
+//-----------------------------------------------------------------------------
+
+static int ini_replace_file(char *temporary, char *target, int success)
+{
+	if (success)
+	{
+#ifdef _WIN32
+		success = MoveFileExA(temporary, target, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+		success = rename(temporary, target) == 0;
+#endif
+
+		if (!success)
+			ini_default_result(INI_ERROR_WRITE_FILE);
+	}
+
+	if (!success)
+		remove(temporary);
+
+	free(temporary);
+	free(target);
+
+	return success;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: write filled hash table to file, entries are grouped by sections
+//-----------------------------------------------------------------------------
+
+int ini_write_data(const struct ini_data *data, const char *filename)
+{
+	if (!ini_load_sections((struct ini_data *)data))
+		return 0;
+
+	// Write new file next to the old one, so failure leaves it as it was
+	char *target;
+	char *temporary;
+	struct ini_writer writer;
+
+	if (!ini_writer_init(&writer))
+		return 0;
+
+	if (!(writer.file = ini_create_temporary(filename, &target, &temporary)))
+	{
+		free(writer.buffer);
+		return 0;
+	}
+
+	int written = 1;
+
+	for (size_t i = 0; written && i < data->section_count; ++i)
+	{
+		const struct ini_section *section = data->sections[i];
+
+		written = ini_writer_section(&writer, section->name, section->length);
+
+		for (size_t j = section->first; written && j < section->first + section->count; ++j)
+		{
+			const struct ini_entry *entry = &data->entries[j];
+
+			written = ini_writer_parameter(&writer, entry->key, entry->key_length, entry->value, entry->value_length);
+		}
+	}
+
+	// Error of writer is reported by closing it
+	return ini_replace_file(temporary, target, ini_writer_close(&writer));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: write parameters of section which are missing in patched file
+//-----------------------------------------------------------------------------
+
+static int ini_patch_missing(struct ini_patch *patch, size_t sectionIndex)
+{
+	const struct ini_section *section = patch->values->sections[sectionIndex];
+
+	for (size_t i = section->first; i < section->first + section->count; ++i)
+	{
+		const struct ini_entry *entry = &patch->values->entries[i];
+
+		if (!patch->found[i] && !ini_writer_parameter(patch->writer, entry->key, entry->key_length, entry->value, entry->value_length))
+			return 0;
+	}
+
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: insert missing parameters after the last parameter of section
+//-----------------------------------------------------------------------------
+
+static int ini_patch_insert(ini_parse_state_t *state)
+{
+	struct ini_patch *patch = state->patch;
+
+	if (patch->insertAt[patch->sectionIndex] != state->lineNext)
+		return 1;
+
+	if (!ini_writer_put(patch->writer, patch->written, state->lineNext - patch->written))
+		return 0;
+
+	patch->written = state->lineNext;
+
+	// The last line of file may have no newline
+	if (*(state->lineNext - 1) != '\n')
+	{
+		if (!ini_writer_put(patch->writer, "\n", 1))
+			return 0;
+
+		patch->isTerminated = 1;
+	}
+
+	return ini_patch_missing(patch, patch->sectionIndex);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: find section of patched file in values
+//-----------------------------------------------------------------------------
+
+static int ini_patch_section(ini_parse_state_t *state, const char *section, size_t length)
+{
+	struct ini_patch *patch = state->patch;
+
+	state->section = ini_find_section(patch->values, section, length, ini_hash(section, length, 0));
+
+	if (!state->section)
+		return 1;
+
+	patch->sectionIndex = state->section->index;
+
+	if (!patch->writer)
+	{
+		patch->insertAt[patch->sectionIndex] = state->lineNext;
+		return 1;
+	}
+
+	return ini_patch_insert(state);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: replace value of parameter of patched file
+//-----------------------------------------------------------------------------
+
+static int ini_patch_parameter(ini_parse_state_t *state, const char *key, size_t keyLength, const char *value, size_t valueLength)
+{
+	struct ini_patch *patch = state->patch;
+
+	if (!state->section)
+		return 1;
+
+	const struct ini_entry *entry = ini_find_entry(patch->values, state->section, key, keyLength, ini_hash(key, keyLength, state->section->hash));
+
+	if (!patch->writer)
+	{
+		if (entry)
+			patch->found[entry - patch->values->entries] = 1;
+
+		patch->insertAt[patch->sectionIndex] = state->lineNext;
+		return 1;
+	}
+
+	// Keep the rest of line, comments and spaces
+	if (entry && (entry->value_length != valueLength || memcmp(entry->value, value, valueLength)))
+	{
+		if (!ini_writer_put(patch->writer, patch->written, value - patch->written) ||
+			!ini_writer_put(patch->writer, entry->value, entry->value_length))
+		{
+			return 0;
+		}
+
+		patch->written = value + valueLength;
+	}
+
+	return ini_patch_insert(state);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: replace changed values of parameters in file keeping the rest
+//-----------------------------------------------------------------------------
+
+int ini_patch_file(const char *filename, const struct ini_data *values)
+{
+	if (!ini_load_sections((struct ini_data *)values))
+		return 0;
+
+	for (size_t i = 0; i < values->entry_count; ++i)
+	{
+		const struct ini_entry *entry = &values->entries[i];
+
+		if (!ini_is_writable(entry->section->name, entry->section->length, STRING_SECTION) ||
+			!ini_is_writable(entry->key, entry->key_length, STRING_KEY) ||
+			!ini_is_writable(entry->value, entry->value_length, STRING_VALUE))
+		{
+			return ini_default_result(INI_ERROR_INVALID_STRING);
+		}
+	}
+
+	void *mapping;
+	size_t size;
+
+	if (!ini_map_file(filename, &mapping, &size))
+		return ini_missing_file(&s_default_parser);
+
+	const char *text = (const char *)mapping;
+
+	struct ini_patch patch;
+	memset(&patch, 0, sizeof(patch));
+
+	patch.values = values;
+	patch.found = calloc(values->entry_count + 1, 1);
+	patch.insertAt = calloc(values->section_count + 1, sizeof(const char *));
+
+	int success = (patch.found && patch.insertAt);
+
+	if (!success)
+		ini_default_result(INI_ERROR_OUT_OF_MEMORY);
+
+	ini_parse_state_t state;
+
+	// Find parameters and ends of sections
+	if (success)
+	{
+		ini_init_state(&state, &s_default_parser, PARSE_PATCH, NULL, NULL, NULL, NULL);
+		state.reference = 1;
+		state.patch = &patch;
+
+		success = ini_finish_state(&state, ini_parse_text(&state, text, size));
+	}
+
+	// Write new file next to the old one and replace it at once
+	char *target = NULL;
+	char *temporary = NULL;
+	struct ini_writer writer;
+
+	if (success)
+		success = ini_writer_init(&writer);
+
+	if (success && !(writer.file = ini_create_temporary(filename, &target, &temporary)))
+	{
+		free(writer.buffer);
+		success = 0;
+	}
+
+	if (success)
+	{
+		patch.writer = &writer;
+		patch.written = text;
+
+		ini_init_state(&state, &s_default_parser, PARSE_PATCH, NULL, NULL, NULL, NULL);
+		state.reference = 1;
+		state.patch = &patch;
+
+		int written = ini_parse_text(&state, text, size) && ini_writer_put(&writer, patch.written, text + size - patch.written);
+
+		// Sections missing in file are appended
+		if (written && size > 0 && text[size - 1] != '\n' && !patch.isTerminated)
+			written = ini_writer_put(&writer, "\n", 1);
+
+		writer.is_written = (size > 0);
+
+		for (size_t i = 0; written && i < values->section_count; ++i)
+		{
+			const struct ini_section *section = values->sections[i];
+
+			if (patch.insertAt[i] || !section->count)
+				continue;
+
+			written = ini_writer_section(&writer, section->name, section->length) && ini_patch_missing(&patch, i);
+		}
+
+		ini_finish_state(&state, 1);
+		success = ini_writer_close(&writer) && written;
+	}
+
+	ini_unmap_file(mapping, size);
+	free(patch.found);
+	free((void *)patch.insertAt);
+
+	if (!temporary)
+		return 0;
+
+	return ini_replace_file(temporary, target, success);
 }
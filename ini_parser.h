@@ -24,6 +24,9 @@
 #ifndef INI_PARSER_H
 #define INI_PARSER_H
 
+#include <stddef.h>
+#include <stdio.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -35,10 +38,16 @@ extern "C" {
 #define INI_BUFFER_LENGTH 256
 
 //-----------------------------------------------------------------------------
-// Size of hash table
+// Initial size of hash table (power of two), it grows with number of entries
+//-----------------------------------------------------------------------------
+
+#define INI_HASH_TABLE_SIZE 64
+
+//-----------------------------------------------------------------------------
+// Size in bytes of first chunk of arena, next chunks grow up to 64 times of it
 //-----------------------------------------------------------------------------
 
-#define INI_HASH_TABLE_SIZE 63
+#define INI_ARENA_CHUNK_SIZE 16384
 
 //-----------------------------------------------------------------------------
 // Prefixes of comments
@@ -64,6 +73,13 @@ extern "C" {
 
 #define INI_PARAMETER_DELIMITER "="
 
+//-----------------------------------------------------------------------------
+// Collect statistics of parsing (see ini_parser_set_stats), counters aren't
+// compiled without it
+//-----------------------------------------------------------------------------
+
+// #define INI_STATS
+
 //-----------------------------------------------------------------------------
 // Helper macros
 //-----------------------------------------------------------------------------
@@ -78,6 +94,7 @@ extern "C" {
 #define INI_FIELDTYPE_BYTE(datatype) datatype.fieldtype = INI_FIELD_BYTE
 #define INI_FIELDTYPE_CHAR(datatype) datatype.fieldtype = INI_FIELD_CHAR
 #define INI_FIELDTYPE_CSTRING(datatype) datatype.fieldtype = INI_FIELD_CSTRING
+#define INI_FIELDTYPE_STRING_VIEW(datatype) datatype.fieldtype = INI_FIELD_STRING_VIEW
 #define INI_FIELDTYPE_UINT32(datatype, basis) datatype.fieldtype = INI_FIELD_UINT32; datatype.radix = ((basis < 0) ? 0 : (basis > 16) ? 16 : basis)
 #define INI_FIELDTYPE_UINT64(datatype, basis) datatype.fieldtype = INI_FIELD_UINT64; datatype.radix = ((basis < 0) ? 0 : (basis > 16) ? 16 : basis)
 #ifdef __cplusplus
@@ -90,6 +107,28 @@ extern "C" {
 
 typedef void (*iniHandlerFn)(const char *pszSection, const char *pszKey, const char *pszValue);
 
+//-----------------------------------------------------------------------------
+// Resolved section and key of hash table for repeated reads
+//-----------------------------------------------------------------------------
+
+struct ini_handle
+{
+	struct ini_entry *entry;
+	unsigned int generation;
+
+	// Names to resolve handle again, must stay alive while handle is used
+	const char *section;
+	const char *key;
+};
+
+//-----------------------------------------------------------------------------
+// Options of parser
+//-----------------------------------------------------------------------------
+
+#define INI_OPTION_MMAP (1 << 0) // map files in memory instead of reading them line by line
+#define INI_OPTION_REFERENCE (1 << 1) // entries refer to parsed buffer instead of copies, buffer must outlive hash table
+#define INI_OPTION_LAZY (1 << 2) // map file and find only sections, their parameters are parsed on first access
+
 //-----------------------------------------------------------------------------
 // Error codes
 //-----------------------------------------------------------------------------
@@ -102,7 +141,16 @@ enum ini_error_code
 	INI_ERROR_SECTION_END_ID,
 	INI_ERROR_SECTION_EMPTY,
 	INI_ERROR_KEY_EMPTY,
-	INI_ERROR_VALUE_EMPTY
+	INI_ERROR_VALUE_EMPTY,
+	INI_ERROR_INVALID_VALUE,
+	INI_ERROR_OUT_OF_RANGE,
+	INI_ERROR_INVALID_FIELD_TYPE,
+	INI_ERROR_BUFFER_TOO_SMALL,
+	INI_ERROR_INVALID_SNAPSHOT,
+	INI_ERROR_WRITE_FILE,
+	INI_ERROR_INVALID_STRING,
+	INI_ERROR_MISSING_PARAMETER,
+	INI_ERROR_OUT_OF_MEMORY
 };
 
 //-----------------------------------------------------------------------------
@@ -120,9 +168,20 @@ typedef enum ini_field_type
 	INI_FIELD_CSTRING,
 	INI_FIELD_UINT32,
 	INI_FIELD_UINT64,
-	INI_FIELD_BOOL
+	INI_FIELD_BOOL,
+	INI_FIELD_STRING_VIEW
 } ini_field_type_t;
 
+//-----------------------------------------------------------------------------
+// String borrowed from storage of value, it's not NUL-terminated
+//-----------------------------------------------------------------------------
+
+struct ini_string_view
+{
+	const char *string;
+	size_t length;
+};
+
 //-----------------------------------------------------------------------------
 // Structure for reading data types
 //-----------------------------------------------------------------------------
@@ -143,6 +202,7 @@ struct ini_datatype
 		const char			*m_pszString;
 		unsigned int		m_uint32;
 		unsigned long long	m_uint64;
+		struct ini_string_view	m_view;
 	#ifdef __cplusplus
 		bool				m_bool;
 	#else
@@ -151,18 +211,109 @@ struct ini_datatype
 	};
 };
 
+//-----------------------------------------------------------------------------
+// Parameter of batched lookup
+//-----------------------------------------------------------------------------
+
+struct ini_query
+{
+	const char *section;
+	const char *key;
+
+	// Type to read (fieldtype and radix) and output value
+	struct ini_datatype datatype;
+
+	// INI_NO_ERROR, INI_ERROR_MISSING_PARAMETER or error of conversion
+	int error_code;
+};
+
+//-----------------------------------------------------------------------------
+// Declared type of parameter to convert its value once at parse time
+//-----------------------------------------------------------------------------
+
+struct ini_typed_key
+{
+	const char *section;
+	const char *key;
+
+	ini_field_type_t fieldtype;
+	int radix;
+};
+
+//-----------------------------------------------------------------------------
+// Section stored once in hash table, entries refer to it
+//-----------------------------------------------------------------------------
+
+struct ini_section
+{
+	const char *name;
+	size_t length;
+
+	unsigned int hash;
+
+	// Position in sections of hash table
+	size_t index;
+
+	// Entries of section are contiguous and in order of appearance:
+	// entries[first] ... entries[first + count - 1]
+	size_t first;
+	size_t count;
+};
+
 //-----------------------------------------------------------------------------
 // Structure of entry used in hash table
+// Strings of entries filled from a mapped file or a referenced buffer point
+// directly into it and are NOT NUL-terminated, use lengths to read them
 //-----------------------------------------------------------------------------
 
 struct ini_entry
 {
-	struct ini_entry *next;
-
 	const char *key;
 	const char *value;
 
-	const char *section;
+	const struct ini_section *section;
+
+	size_t key_length;
+	size_t value_length;
+
+	// Hash of section and key
+	unsigned int hash;
+
+	// Value converted by first read: state holds its field type and radix
+	// (0 - nothing cached)
+	unsigned int cache_state;
+	unsigned long long cache;
+};
+
+//-----------------------------------------------------------------------------
+// Slot of open addressing index: stored hash and position of element + 1
+// (0 - empty slot)
+//-----------------------------------------------------------------------------
+
+struct ini_slot
+{
+	unsigned int hash;
+	unsigned int index;
+};
+
+//-----------------------------------------------------------------------------
+// Chunked bump allocator which keeps entries and their strings
+//-----------------------------------------------------------------------------
+
+struct ini_arena_chunk
+{
+	struct ini_arena_chunk *next;
+
+	size_t size;
+	size_t used;
+};
+
+struct ini_arena
+{
+	struct ini_arena_chunk *head;
+
+	size_t used;
+	size_t reserved;
 };
 
 //-----------------------------------------------------------------------------
@@ -171,78 +322,1273 @@ struct ini_entry
 
 struct ini_data
 {
-	struct ini_entry *entries[INI_HASH_TABLE_SIZE];
+	// Entries grouped by sections, last definition of a key wins
+	struct ini_entry *entries;
+	size_t entry_count;
+	size_t entry_capacity;
+
+	struct ini_slot *slots;
+	size_t slot_count;
+
+	// Interned sections
+	struct ini_section **sections;
+	size_t section_count;
+	size_t section_capacity;
+
+	struct ini_slot *section_slots;
+	size_t section_slot_count;
+
+	// Memory of entries and their strings
+	struct ini_arena arena;
+
+	// Strings refer to parsed text and aren't NUL-terminated
+	int reference;
+
+	// Changes when entries move, handles of other generations are stale
+	unsigned int generation;
+
+	// Mapped file which entries refer to
+	void *mapping;
+	size_t mapping_size;
+
+	// Loaded from snapshot, index tables are inside of the mapping
+	int snapshot;
+
+	// Bodies of sections are parsed on first access (NULL - table is filled)
+	void *lazy;
 };
 
 //-----------------------------------------------------------------------------
-// Purpose: get last error message
+// Entry of layer of overlay which overrides lower layers
 //-----------------------------------------------------------------------------
 
-const char *ini_get_last_error_msg();
+struct ini_overlay_entry
+{
+	struct ini_entry *entry;
+	int priority;
+};
 
 //-----------------------------------------------------------------------------
-// Purpose: get last error code
+// Stack of hash tables, lookup finds parameter of layer with the highest
+// priority. Base table is neither copied nor indexed, overlay keeps only index
+// of entries of other layers, so it can be shared by many overlays
 //-----------------------------------------------------------------------------
 
-int ini_get_last_error();
+struct ini_overlay
+{
+	// The lowest layer (can be NULL)
+	struct ini_data *base;
+
+	// One entry per section and key of other layers
+	struct ini_overlay_entry *entries;
+	size_t entry_count;
+	size_t entry_capacity;
+
+	struct ini_slot *slots;
+	size_t slot_count;
+};
 
 //-----------------------------------------------------------------------------
-// Purpose: get last line where an error has occurred
+// Read-only copy of hash table in one allocation: slots of index followed by
+// records of parameters, each record holds lengths of section, key and value
+// and then their strings. Lookup touches one slot and one record, table is
+// never modified, so any number of threads can read it without locking
 //-----------------------------------------------------------------------------
 
-int ini_get_last_line();
+struct ini_frozen
+{
+	// Hash of section and key and position of record / 8 + 1 (0 - empty slot)
+	struct ini_slot *slots;
+	size_t slot_count;
+
+	// Records of parameters grouped by sections
+	const char *records;
+	size_t records_size;
+
+	size_t entry_count;
+};
 
 //-----------------------------------------------------------------------------
-// Purpose: read data from string
+// Table and result of one of files loaded together
+//-----------------------------------------------------------------------------
+
+struct ini_file
+{
+	char *filename;
+
+	// Empty if file failed
+	struct ini_data data;
+
+	// INI_NO_ERROR, INI_MISSING_FILE, INI_ERROR_OUT_OF_MEMORY or error of parsing
+	int error_code;
+	int line;
+	int column;
+};
+
+//-----------------------------------------------------------------------------
+// Files loaded together, their tables keep strings in arenas of the set (one
+// per thread of loading), names repeated in files are stored once per thread
+//-----------------------------------------------------------------------------
+
+struct ini_files
+{
+	struct ini_file *files;
+	size_t count;
+
+	struct ini_arena *arenas;
+	size_t arena_count;
+};
+
+//-----------------------------------------------------------------------------
+// Statistics of the last parsing, filled only when library is compiled with
+// INI_STATS
+//-----------------------------------------------------------------------------
+
+struct ini_stats
+{
+	unsigned long long bytes;
+	unsigned long long lines;
+
+	// Parsed parameters and headers of sections, repeated ones too
+	unsigned long long entries;
+	unsigned long long sections;
+
+	// Growths of buffer of context for long lines
+	unsigned long long buffer_growths;
+
+	unsigned long long allocations;
+	unsigned long long allocated_bytes;
+
+	// Time of phases in nanoseconds: opening or mapping file, reading and
+	// parsing lines (from begin to finish for incremental parsing),
+	// conversion of declared types
+	unsigned long long read_time;
+	unsigned long long parse_time;
+	unsigned long long convert_time;
+};
+
+//-----------------------------------------------------------------------------
+// Occupancy of open addressing index, probes are counted from home slot
+//-----------------------------------------------------------------------------
+
+struct ini_index_stats
+{
+	size_t slot_count;
+	size_t used_slots;
+	double load_factor;
+
+	// Probes to find present element
+	size_t max_probe;
+	double average_probe;
+
+	// Longest run of used slots, bounds probes to find missing element
+	size_t max_cluster;
+};
+
+struct ini_table_stats
+{
+	struct ini_index_stats entries;
+	struct ini_index_stats sections;
+};
+
+//-----------------------------------------------------------------------------
+// Context of parser, one per thread lets to parse files in parallel
+//-----------------------------------------------------------------------------
+
+struct ini_parser
+{
+	// Buffer to read lines of file
+	char *buffer;
+	size_t buffer_size;
+
+	// Last error
+	int error_code;
+	int line;
+	int column;
+
+	int options;
+
+	// Parameters converted when hash table is filled
+	const struct ini_typed_key *types;
+	size_t type_count;
+
+	// State of unfinished incremental parsing
+	void *stream;
+
+	// Filled by parsing when compiled with INI_STATS (NULL - not collected)
+	struct ini_stats *stats;
+};
+
+//-----------------------------------------------------------------------------
+// Binding of parameter to member of user structure
+//-----------------------------------------------------------------------------
+
+struct ini_schema_field
+{
+	const char *section;
+	const char *key;
+
+	ini_field_type_t fieldtype;
+	int radix;
+
+	// Offset of member in structure
+	size_t offset;
+};
+
+#define INI_SCHEMA_FIELD(type, member, section, key, fieldtype, radix) { section, key, fieldtype, radix, offsetof(type, member) }
+
+//-----------------------------------------------------------------------------
+// Compiled schema, each parameter is found by a single probe of perfect hash,
+// parameters with colliding hashes are chained behind the same slot
+//-----------------------------------------------------------------------------
+
+struct ini_schema
+{
+	const struct ini_schema_field *fields;
+	size_t field_count;
+
+	// Index of field + 1 by position of its hash (0 - empty)
+	struct ini_slot *slots;
+	unsigned int seed;
+	unsigned int shift;
+
+	// Index of next field + 1 with the same hash (NULL - no such fields)
+	unsigned int *chain;
+};
+
+//-----------------------------------------------------------------------------
+// Buffered writer of .ini file
+//-----------------------------------------------------------------------------
+
+struct ini_writer
+{
+	FILE *file;
+
+	char *buffer;
+	size_t used;
+
+	// Current section, header is written when it changes
+	char *section;
+	size_t section_length;
+	size_t section_size;
+
+	int is_written;
+	int error_code;
+};
+
+//-----------------------------------------------------------------------------
+// Kind of change reported by reloader
+//-----------------------------------------------------------------------------
+
+enum ini_change
+{
+	INI_CHANGE_ADDED = 0,
+	INI_CHANGE_REMOVED,
+	INI_CHANGE_MODIFIED,
+	INI_CHANGE_FAILED // reload failed, error is in context of reloader
+};
+
+//-----------------------------------------------------------------------------
+// Signature of function called after reload, entries are NULL when they don't
+// exist in previous or current table
+//-----------------------------------------------------------------------------
+
+typedef void (*iniChangeFn)(void *context, int change, const struct ini_entry *previous, const struct ini_entry *current);
+
+//-----------------------------------------------------------------------------
+// Table reloaded when file changes, readers never block and never see table
+// which is being parsed or freed
+//-----------------------------------------------------------------------------
+
+struct ini_reloader
+{
+	char *filename;
+
+	// Context of reloading, used under lock
+	struct ini_parser parser;
+
+	// Published table
+	struct ini_data *current;
+
+	// Readers of the current and the previous epoch
+	unsigned int epoch;
+	unsigned int readers[2];
+
+	iniChangeFn on_change;
+	void *context;
+
+	// Thread watching file and lock of reloading
+	void *watcher;
+};
+
+//-----------------------------------------------------------------------------
+// Purpose: initialize context of parser
 //
 // Params:
-// @value - string to read
-// @datatype - field type to read
-// @fieldtype - directly read data type (-1 - ignore)
+// @parser - pointer to context
+// @options - combination of INI_OPTION_* flags
+//-----------------------------------------------------------------------------
+
+void ini_parser_init(struct ini_parser *parser, int options);
+
+//-----------------------------------------------------------------------------
+// Purpose: free allocated memory of context of parser
 //
-// Return value: 1 - success, 0 - failed to read data
+// Params:
+// @parser - pointer to context
 //-----------------------------------------------------------------------------
 
-int ini_read_string(const char *value, struct ini_datatype *datatype, int fieldtype);
+void ini_parser_free(struct ini_parser *parser);
 
 //-----------------------------------------------------------------------------
-// Purpose: read data from filled hash table
+// Purpose: declare types of parameters to convert and cache them when hash
+// table is filled, failed conversion fails parsing
 //
 // Params:
-// @data - pointer to hash table
-// @section - name of section
-// @key - name of parameter
-// @datatype - field type to read
-// @fieldtype - directly read data type (-1 - ignore)
+// @parser - pointer to context
+// @types - array of typed parameters (must stay alive while context is used)
+// @count - size of array
+//-----------------------------------------------------------------------------
+
+void ini_parser_set_types(struct ini_parser *parser, const struct ini_typed_key *types, size_t count);
+
+//-----------------------------------------------------------------------------
+// Purpose: collect statistics of each parsing of context, they're reset when
+// parsing starts
 //
-// Return value: 1 - success, 0 - failed to read data
+// Params:
+// @parser - pointer to context
+// @stats - statistics to fill (must stay alive while context is used), NULL
+// stops collecting
+//
+// Return value: 1 - success, 0 - library is compiled without INI_STATS
 //-----------------------------------------------------------------------------
 
-int ini_read_data(struct ini_data *data, const char *section, const char *key, struct ini_datatype *datatype, int fieldtype);
+int ini_parser_set_stats(struct ini_parser *parser, struct ini_stats *stats);
 
 //-----------------------------------------------------------------------------
-// Purpose: save data from .ini file in hash table
+// Purpose: get message of last error of context
+//
+// Params:
+// @parser - pointer to context
+//-----------------------------------------------------------------------------
+
+const char *ini_parser_get_error_msg(const struct ini_parser *parser);
+
+//-----------------------------------------------------------------------------
+// Purpose: save data from .ini file in hash table using context of parser
 //
 // Params:
+// @parser - pointer to context
 // @filename - directory of file
 // @data - pointer to hash table
 //
 // Return value: 1 - success, 0 - failed to parse file
 //-----------------------------------------------------------------------------
 
-int ini_parse_data(const char *filename, struct ini_data *data);
+int ini_parser_parse_data(struct ini_parser *parser, const char *filename, struct ini_data *data);
 
 //-----------------------------------------------------------------------------
-// Purpose: call a callback when parse .ini file
+// Purpose: call a callback when parse .ini file using context of parser
 //
 // Params:
+// @parser - pointer to context
 // @filename - directory of file
 // @handler - pointer to function handler
 //
 // Return value: 1 - success, 0 - failed to parse file
 //-----------------------------------------------------------------------------
 
-int ini_parse_handler(const char *filename, iniHandlerFn handler);
+int ini_parser_parse_handler(struct ini_parser *parser, const char *filename, iniHandlerFn handler);
+
+//-----------------------------------------------------------------------------
+// Purpose: save data from .ini text in memory in hash table using context of
+// parser, buffer is never modified
+//
+// Params:
+// @parser - pointer to context
+// @buffer - text of .ini file (not necessarily NUL-terminated)
+// @length - length of text
+// @data - pointer to hash table
+//
+// Return value: 1 - success, 0 - failed to parse text
+//-----------------------------------------------------------------------------
+
+int ini_parser_parse_buffer_data(struct ini_parser *parser, const char *buffer, size_t length, struct ini_data *data);
+
+//-----------------------------------------------------------------------------
+// Purpose: call a callback when parse .ini text in memory using context of
+// parser, buffer is never modified
+//
+// Params:
+// @parser - pointer to context
+// @buffer - text of .ini file (not necessarily NUL-terminated)
+// @length - length of text
+// @handler - pointer to function handler
+//
+// Return value: 1 - success, 0 - failed to parse text
+//-----------------------------------------------------------------------------
+
+int ini_parser_parse_buffer_handler(struct ini_parser *parser, const char *buffer, size_t length, iniHandlerFn handler);
+
+//-----------------------------------------------------------------------------
+// Purpose: save data from .ini file in hash table using context of parser,
+// file is mapped in memory, split at sections and its parts are parsed in
+// parallel (result, errors and their lines are the same as of serial parsing)
+//
+// Params:
+// @parser - pointer to context
+// @filename - directory of file
+// @data - pointer to hash table
+// @threads - number of threads (0 - number of processors)
+//
+// Return value: 1 - success, 0 - failed to parse file
+//-----------------------------------------------------------------------------
+
+int ini_parser_parse_parallel_data(struct ini_parser *parser, const char *filename, struct ini_data *data, int threads);
+
+//-----------------------------------------------------------------------------
+// Purpose: save data from .ini text in memory in hash table using context of
+// parser, parts of text are parsed in parallel
+//
+// Params:
+// @parser - pointer to context
+// @buffer - text of .ini file
+// @length - length of text
+// @data - pointer to hash table
+// @threads - number of threads (0 - number of processors)
+//
+// Return value: 1 - success, 0 - failed to parse text
+//-----------------------------------------------------------------------------
+
+int ini_parser_parse_buffer_parallel_data(struct ini_parser *parser, const char *buffer, size_t length, struct ini_data *data, int threads);
+
+//-----------------------------------------------------------------------------
+// Purpose: start incremental parsing to fill hash table, text is passed by
+// ini_parser_feed in chunks of any size (e.g. read from pipe or socket)
+//
+// Params:
+// @parser - pointer to context
+// @data - pointer to hash table
+//
+// Return value: 1 - success, 0 - failed to allocate memory
+//-----------------------------------------------------------------------------
+
+int ini_parser_begin_data(struct ini_parser *parser, struct ini_data *data);
+
+//-----------------------------------------------------------------------------
+// Purpose: start incremental parsing, callback is called as soon as line of
+// parameter is complete
+//
+// Params:
+// @parser - pointer to context
+// @handler - pointer to function handler
+//
+// Return value: 1 - success, 0 - failed to allocate memory
+//-----------------------------------------------------------------------------
+
+int ini_parser_begin_handler(struct ini_parser *parser, iniHandlerFn handler);
+
+//-----------------------------------------------------------------------------
+// Purpose: start incremental parsing directly into members of structure
+//
+// Params:
+// @parser - pointer to context
+// @schema - compiled schema
+// @object - pointer to structure
+//
+// Return value: 1 - success, 0 - failed to allocate memory
+//-----------------------------------------------------------------------------
+
+int ini_parser_begin_schema(struct ini_parser *parser, const struct ini_schema *schema, void *object);
+
+//-----------------------------------------------------------------------------
+// Purpose: parse next chunk of text, line split between chunks is kept in
+// buffer of context until its end comes
+//
+// Params:
+// @parser - pointer to context
+// @chunk - part of text (it isn't referenced after the call)
+// @length - length of part
+//
+// Return value: 1 - success, 0 - failed to parse text (parsing is finished)
+//-----------------------------------------------------------------------------
+
+int ini_parser_feed(struct ini_parser *parser, const char *chunk, size_t length);
+
+//-----------------------------------------------------------------------------
+// Purpose: parse the last line and finish incremental parsing
+//
+// Params:
+// @parser - pointer to context
+//
+// Return value: 1 - success, 0 - failed to parse text or parsing isn't started
+//-----------------------------------------------------------------------------
+
+int ini_parser_finish(struct ini_parser *parser);
+
+//-----------------------------------------------------------------------------
+// Purpose: compile schema, build perfect hash of its parameters
+//
+// Params:
+// @schema - schema to fill
+// @fields - array of fields (must stay alive while schema is used)
+// @count - size of array
+//
+// Return value: 1 - success, 0 - unsupported field type (INI_ERROR_INVALID_FIELD_TYPE),
+// repeated parameter (INI_ERROR_INVALID_STRING) or failed to allocate memory
+// (INI_ERROR_OUT_OF_MEMORY), schema stays empty then
+//-----------------------------------------------------------------------------
+
+int ini_schema_compile(struct ini_schema *schema, const struct ini_schema_field *fields, size_t count);
+
+//-----------------------------------------------------------------------------
+// Purpose: free allocated memory of schema
+//
+// Params:
+// @schema - compiled schema
+//-----------------------------------------------------------------------------
+
+void ini_schema_free(struct ini_schema *schema);
+
+//-----------------------------------------------------------------------------
+// Purpose: convert parameters of .ini file directly into members of structure
+// using context of parser, unknown parameters are skipped
+//
+// Params:
+// @parser - pointer to context
+// @filename - directory of file
+// @schema - compiled schema
+// @object - pointer to structure (string members must be NULL or allocated
+// by previous parsing, repeated parameters free them)
+//
+// Return value: 1 - success, 0 - failed to parse file or to convert value
+//-----------------------------------------------------------------------------
+
+int ini_parser_parse_schema(struct ini_parser *parser, const char *filename, const struct ini_schema *schema, void *object);
+
+//-----------------------------------------------------------------------------
+// Purpose: convert parameters of .ini text in memory directly into members of
+// structure using context of parser
+//
+// Params:
+// @parser - pointer to context
+// @buffer - text of .ini file
+// @length - length of text
+// @schema - compiled schema
+// @object - pointer to structure
+//
+// Return value: 1 - success, 0 - failed to parse text or to convert value
+//-----------------------------------------------------------------------------
+
+int ini_parser_parse_buffer_schema(struct ini_parser *parser, const char *buffer, size_t length, const struct ini_schema *schema, void *object);
+
+//-----------------------------------------------------------------------------
+// Functions below use default context of the calling thread
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Purpose: get last error message
+//-----------------------------------------------------------------------------
+
+const char *ini_get_last_error_msg();
+
+//-----------------------------------------------------------------------------
+// Purpose: get last error code
+//-----------------------------------------------------------------------------
+
+int ini_get_last_error();
+
+//-----------------------------------------------------------------------------
+// Purpose: get last line where an error has occurred
+//-----------------------------------------------------------------------------
+
+int ini_get_last_line();
+
+//-----------------------------------------------------------------------------
+// Purpose: get last column where an error has occurred
+//-----------------------------------------------------------------------------
+
+int ini_get_last_column();
+
+//-----------------------------------------------------------------------------
+// Purpose: collect statistics of parsing of default context of the calling
+// thread (ini_parse_data, ini_parse_handler and others)
+//
+// Params:
+// @stats - statistics to fill, NULL stops collecting
+//
+// Return value: 1 - success, 0 - library is compiled without INI_STATS
+//-----------------------------------------------------------------------------
+
+int ini_set_stats(struct ini_stats *stats);
+
+//-----------------------------------------------------------------------------
+// Purpose: read data from string
+//
+// Params:
+// @value - string to read
+// @datatype - field type to read
+// @fieldtype - directly read data type (-1 - ignore)
+//
+// Return value: 1 - success, 0 - failed to read data
+//-----------------------------------------------------------------------------
+
+int ini_read_string(const char *value, struct ini_datatype *datatype, int fieldtype);
+
+//-----------------------------------------------------------------------------
+// Purpose: read data from filled hash table
+//
+// Params:
+// @data - pointer to hash table
+// @section - name of section
+// @key - name of parameter
+// @datatype - field type to read
+// @fieldtype - directly read data type (-1 - ignore)
+//
+// Return value: 1 - success, 0 - failed to read data
+//-----------------------------------------------------------------------------
+
+int ini_read_data(struct ini_data *data, const char *section, const char *key, struct ini_datatype *datatype, int fieldtype);
+
+//-----------------------------------------------------------------------------
+// Purpose: read many parameters from filled hash table at once, names are
+// hashed and slots and entries are loaded for several queries together, values
+// are converted grouped by types
+//
+// Params:
+// @data - pointer to hash table
+// @queries - array of queries, each one gets its value and error code
+// @count - size of array
+//
+// Return value: number of successfully read parameters
+//-----------------------------------------------------------------------------
+
+size_t ini_read_many(struct ini_data *data, struct ini_query *queries, size_t count);
+
+//-----------------------------------------------------------------------------
+// Purpose: copy value of parameter from filled hash table to buffer without
+// allocation, copied string is always NUL-terminated
+//
+// Params:
+// @data - pointer to hash table
+// @section - name of section
+// @key - name of parameter
+// @buffer - destination buffer
+// @size - size of buffer
+// @length - receives length of value without NUL (can be NULL), it's set even
+// when buffer is too small
+//
+// Return value: 1 - success, 0 - missing parameter or value is truncated
+//-----------------------------------------------------------------------------
+
+int ini_copy_data(struct ini_data *data, const char *section, const char *key, char *buffer, size_t size, size_t *length);
+
+//-----------------------------------------------------------------------------
+// Purpose: free string of INI_FIELD_CSTRING, allocated by this library
+//
+// Params:
+// @string - string to free (can be NULL)
+//-----------------------------------------------------------------------------
+
+void ini_free_string(const char *string);
+
+//-----------------------------------------------------------------------------
+// Purpose: convert values of parameters and cache them in filled hash table,
+// next reads of these types are plain loads
+//
+// Params:
+// @data - pointer to hash table
+// @types - array of typed parameters, missing parameters are skipped
+// @count - size of array
+//
+// Return value: 1 - success, 0 - failed to convert some value
+//-----------------------------------------------------------------------------
+
+int ini_convert_data(struct ini_data *data, const struct ini_typed_key *types, size_t count);
+
+//-----------------------------------------------------------------------------
+// Purpose: resolve section and key of hash table to handle, so next reads
+// don't need to hash and compare names
+//
+// Params:
+// @data - pointer to hash table
+// @section - name of section (pointer is kept in handle)
+// @key - name of parameter (pointer is kept in handle)
+// @handle - handle to fill
+//
+// Return value: 1 - entry is found, 0 - entry is missing
+//-----------------------------------------------------------------------------
+
+int ini_resolve_handle(struct ini_data *data, const char *section, const char *key, struct ini_handle *handle);
+
+//-----------------------------------------------------------------------------
+// Purpose: check if handle refers to existing entry of the current state of
+// hash table (after reload or free of hash table handle becomes stale)
+//
+// Params:
+// @data - pointer to hash table
+// @handle - resolved handle
+//
+// Return value: 1 - handle is valid, 0 - handle is stale or entry is missing
+//-----------------------------------------------------------------------------
+
+int ini_is_handle_valid(const struct ini_data *data, const struct ini_handle *handle);
+
+//-----------------------------------------------------------------------------
+// Purpose: read data using resolved handle, stale handle is resolved again
+//
+// Params:
+// @data - pointer to hash table
+// @handle - resolved handle
+// @datatype - field type to read
+// @fieldtype - directly read data type (-1 - ignore)
+//
+// Return value: 1 - success, 0 - failed to read data
+//-----------------------------------------------------------------------------
+
+int ini_read_handle(struct ini_data *data, struct ini_handle *handle, struct ini_datatype *datatype, int fieldtype);
+
+//-----------------------------------------------------------------------------
+// Purpose: find section of filled hash table by name
+//
+// Params:
+// @data - pointer to hash table
+// @name - name of section
+//
+// Return value: section or NULL if it's missing
+//-----------------------------------------------------------------------------
+
+const struct ini_section *ini_get_section(const struct ini_data *data, const char *name);
+
+//-----------------------------------------------------------------------------
+// Purpose: iterate sections of filled hash table in order of appearance
+//
+// Params:
+// @data - pointer to hash table
+// @section - previous section (NULL - start from the first one)
+// @prefix - beginning of names of wanted sections (NULL - all sections)
+//
+// Return value: next section or NULL if there's no more
+//-----------------------------------------------------------------------------
+
+const struct ini_section *ini_next_section(const struct ini_data *data, const struct ini_section *section, const char *prefix);
+
+//-----------------------------------------------------------------------------
+// Purpose: get entries of section, they're contiguous and in order of
+// appearance
+//
+// Params:
+// @data - pointer to hash table
+// @section - section of this hash table
+// @count - output number of entries
+//
+// Return value: pointer to the first entry
+//-----------------------------------------------------------------------------
+
+const struct ini_entry *ini_get_entries(const struct ini_data *data, const struct ini_section *section, size_t *count);
+
+//-----------------------------------------------------------------------------
+// Purpose: initialize overlay on top of base hash table, base must stay alive
+// and unchanged while overlay is used
+//
+// Params:
+// @overlay - overlay to initialize
+// @base - the lowest layer (can be NULL)
+//-----------------------------------------------------------------------------
+
+void ini_overlay_init(struct ini_overlay *overlay, struct ini_data *base);
+
+//-----------------------------------------------------------------------------
+// Purpose: add layer above base, its entries are indexed by overlay without
+// copying, so layer must stay alive and unchanged while overlay is used
+//
+// Params:
+// @overlay - pointer to overlay
+// @data - hash table of layer
+// @priority - layer with higher priority wins, with equal priority the layer
+// added later wins, base is below all layers
+//
+// Return value: 1 - success, 0 - failed to allocate memory (overlay is left
+// as it was)
+//-----------------------------------------------------------------------------
+
+int ini_overlay_add(struct ini_overlay *overlay, struct ini_data *data, int priority);
+
+//-----------------------------------------------------------------------------
+// Purpose: find parameter of layer with the highest priority
+//
+// Params:
+// @overlay - pointer to overlay
+// @section - name of section
+// @key - name of parameter
+//
+// Return value: entry or NULL if it's missing in all layers
+//-----------------------------------------------------------------------------
+
+const struct ini_entry *ini_overlay_get_entry(const struct ini_overlay *overlay, const char *section, const char *key);
+
+//-----------------------------------------------------------------------------
+// Purpose: read data of layer with the highest priority
+//
+// Params:
+// @overlay - pointer to overlay
+// @section - name of section
+// @key - name of parameter
+// @datatype - field type to read
+// @fieldtype - directly read data type (-1 - ignore)
+//
+// Return value: 1 - success, 0 - failed to read data
+//-----------------------------------------------------------------------------
+
+int ini_overlay_read(struct ini_overlay *overlay, const char *section, const char *key, struct ini_datatype *datatype, int fieldtype);
+
+//-----------------------------------------------------------------------------
+// Purpose: free index of overlay, hash tables of layers aren't freed
+//
+// Params:
+// @overlay - pointer to overlay
+//-----------------------------------------------------------------------------
+
+void ini_overlay_free(struct ini_overlay *overlay);
+
+//-----------------------------------------------------------------------------
+// Purpose: copy filled hash table into compact read-only layout, hash table
+// can be freed after that
+//
+// Params:
+// @data - pointer to hash table
+// @frozen - output frozen table
+//
+// Return value: 1 - success, 0 - failed to allocate memory or table is too
+// large (records over 32 GB)
+//-----------------------------------------------------------------------------
+
+int ini_freeze(const struct ini_data *data, struct ini_frozen *frozen);
+
+//-----------------------------------------------------------------------------
+// Purpose: read data from frozen hash table, values aren't cached, so
+// conversion is done by each read (INI_FIELD_STRING_VIEW is NUL-terminated)
+//
+// Params:
+// @frozen - pointer to frozen table
+// @section - name of section
+// @key - name of parameter
+// @datatype - field type to read
+// @fieldtype - directly read data type (-1 - ignore)
+//
+// Return value: 1 - success, 0 - failed to read data
+//-----------------------------------------------------------------------------
+
+int ini_frozen_read(const struct ini_frozen *frozen, const char *section, const char *key, struct ini_datatype *datatype, int fieldtype);
+
+//-----------------------------------------------------------------------------
+// Purpose: free memory of frozen hash table
+//
+// Params:
+// @frozen - pointer to frozen table
+//-----------------------------------------------------------------------------
+
+void ini_frozen_free(struct ini_frozen *frozen);
+
+//-----------------------------------------------------------------------------
+// Purpose: parse bodies of all sections of hash table filled lazily, it's
+// done by functions which need the whole table (writing, snapshot, overlay)
+//
+// Params:
+// @data - pointer to hash table
+//
+// Return value: 1 - success, 0 - body of some section has error
+//-----------------------------------------------------------------------------
+
+int ini_load_sections(struct ini_data *data);
+
+//-----------------------------------------------------------------------------
+// Purpose: save data from .ini file in hash table
+//
+// Params:
+// @filename - directory of file
+// @data - pointer to hash table
+//
+// Return value: 1 - success, 0 - failed to parse file
+//-----------------------------------------------------------------------------
+
+int ini_parse_data(const char *filename, struct ini_data *data);
+
+//-----------------------------------------------------------------------------
+// Purpose: call a callback when parse .ini file
+//
+// Params:
+// @filename - directory of file
+// @handler - pointer to function handler
+//
+// Return value: 1 - success, 0 - failed to parse file
+//-----------------------------------------------------------------------------
+
+int ini_parse_handler(const char *filename, iniHandlerFn handler);
+
+//-----------------------------------------------------------------------------
+// Purpose: save data from .ini text in memory in hash table, strings are copied
+//
+// Params:
+// @buffer - text of .ini file (not necessarily NUL-terminated)
+// @length - length of text
+// @data - pointer to hash table
+//
+// Return value: 1 - success, 0 - failed to parse text
+//-----------------------------------------------------------------------------
+
+int ini_parse_buffer_data(const char *buffer, size_t length, struct ini_data *data);
+
+//-----------------------------------------------------------------------------
+// Purpose: call a callback when parse .ini text in memory
+//
+// Params:
+// @buffer - text of .ini file (not necessarily NUL-terminated)
+// @length - length of text
+// @handler - pointer to function handler
+//
+// Return value: 1 - success, 0 - failed to parse text
+//-----------------------------------------------------------------------------
+
+int ini_parse_buffer_handler(const char *buffer, size_t length, iniHandlerFn handler);
+
+//-----------------------------------------------------------------------------
+// Purpose: map .ini file in memory and save its data in hash table without
+// copying strings, mapping is released by ini_free_data
+//
+// Params:
+// @filename - directory of file
+// @data - pointer to hash table
+//
+// Return value: 1 - success, 0 - failed to parse file
+//-----------------------------------------------------------------------------
+
+int ini_parse_mmap_data(const char *filename, struct ini_data *data);
+
+//-----------------------------------------------------------------------------
+// Purpose: map .ini file in memory and call a callback when parse it
+//
+// Params:
+// @filename - directory of file
+// @handler - pointer to function handler
+//
+// Return value: 1 - success, 0 - failed to parse file
+//-----------------------------------------------------------------------------
+
+int ini_parse_mmap_handler(const char *filename, iniHandlerFn handler);
+
+//-----------------------------------------------------------------------------
+// Purpose: map .ini file and find its sections, parameters of section are
+// parsed and saved in hash table on first access to it (reading, handle,
+// iteration), it's safe to access from several threads. Errors of parameters
+// are reported by the access to their section
+//
+// Params:
+// @filename - directory of file
+// @data - pointer to hash table
+//
+// Return value: 1 - success, 0 - failed to parse headers of sections
+//-----------------------------------------------------------------------------
+
+int ini_parse_lazy_data(const char *filename, struct ini_data *data);
+
+//-----------------------------------------------------------------------------
+// Purpose: save data from .ini file in hash table, parts of file are parsed in
+// parallel
+//
+// Params:
+// @filename - directory of file
+// @data - pointer to hash table
+// @threads - number of threads (0 - number of processors)
+//
+// Return value: 1 - success, 0 - failed to parse file
+//-----------------------------------------------------------------------------
+
+int ini_parse_parallel_data(const char *filename, struct ini_data *data, int threads);
+
+//-----------------------------------------------------------------------------
+// Purpose: load many files into their own hash tables on several threads,
+// each file is read by one request and parsed from memory
+//
+// Params:
+// @filenames - array of names of files
+// @count - size of array
+// @files - output set of files in order of array, free it by ini_free_files
+// (even if function failed)
+// @threads - number of threads (0 - number of processors)
+//
+// Return value: 1 - all files are parsed, 0 - out of memory or some file
+// failed (see errors of files, the first one is in default context too)
+//-----------------------------------------------------------------------------
+
+int ini_parse_files(const char *const *filenames, size_t count, struct ini_files *files, int threads);
+
+//-----------------------------------------------------------------------------
+// Purpose: load files of directory (without subdirectories) like
+// ini_parse_files, files are sorted by names
+//
+// Params:
+// @directory - path of directory
+// @extension - end of names of loaded files, e.g. ".ini" (NULL - all files)
+// @files - output set of files, free it by ini_free_files (even if function
+// failed)
+// @threads - number of threads (0 - number of processors)
+//
+// Return value: 1 - all files are parsed, 0 - missing directory, out of memory
+// or some file failed
+//-----------------------------------------------------------------------------
+
+int ini_parse_directory(const char *directory, const char *extension, struct ini_files *files, int threads);
+
+//-----------------------------------------------------------------------------
+// Purpose: join loaded files in one namespace without copying, files which
+// come later override the earlier ones, failed files are skipped
+//
+// Params:
+// @files - set of loaded files, it must outlive overlay
+// @overlay - output overlay, free it by ini_overlay_free
+//
+// Return value: 1 - success, 0 - failed to allocate memory
+//-----------------------------------------------------------------------------
+
+int ini_merge_files(struct ini_files *files, struct ini_overlay *overlay);
+
+//-----------------------------------------------------------------------------
+// Purpose: free tables, names and strings of loaded files
+//
+// Params:
+// @files - set of files
+//-----------------------------------------------------------------------------
+
+void ini_free_files(struct ini_files *files);
+
+//-----------------------------------------------------------------------------
+// Purpose: convert parameters of .ini file directly into members of structure
+//
+// Params:
+// @filename - directory of file
+// @schema - compiled schema
+// @object - pointer to structure
+//
+// Return value: 1 - success, 0 - failed to parse file or to convert value
+//-----------------------------------------------------------------------------
+
+int ini_parse_schema(const char *filename, const struct ini_schema *schema, void *object);
+
+//-----------------------------------------------------------------------------
+// Purpose: convert parameters of .ini text in memory directly into members of
+// structure
+//
+// Params:
+// @buffer - text of .ini file
+// @length - length of text
+// @schema - compiled schema
+// @object - pointer to structure
+//
+// Return value: 1 - success, 0 - failed to parse text or to convert value
+//-----------------------------------------------------------------------------
+
+int ini_parse_buffer_schema(const char *buffer, size_t length, const struct ini_schema *schema, void *object);
+
+//-----------------------------------------------------------------------------
+// Purpose: save filled hash table to binary snapshot (hash index, sections and
+// strings), it can be loaded on machine with the same byte order
+//
+// Params:
+// @data - pointer to hash table
+// @filename - directory of file (write to temporary file and rename it if
+// other processes may load it at the same time)
+//
+// Return value: 1 - success, 0 - failed to write file
+//-----------------------------------------------------------------------------
+
+int ini_save_snapshot(const struct ini_data *data, const char *filename);
+
+//-----------------------------------------------------------------------------
+// Purpose: load snapshot by mapping it in memory, lookups use its hash index
+// in place and strings point into the mapping (NUL-terminated)
+//
+// Params:
+// @filename - directory of file
+// @data - pointer to hash table, free it by ini_free_data
+//
+// Return value: 1 - success, 0 - missing file or damaged snapshot
+//-----------------------------------------------------------------------------
+
+int ini_load_snapshot(const char *filename, struct ini_data *data);
+
+//-----------------------------------------------------------------------------
+// Purpose: open file to write parameters through large buffer
+//
+// Params:
+// @writer - writer to initialize
+// @filename - directory of file
+//
+// Return value: 1 - success, 0 - failed to open file
+//-----------------------------------------------------------------------------
+
+int ini_writer_open(struct ini_writer *writer, const char *filename);
+
+//-----------------------------------------------------------------------------
+// Purpose: write parameter, header of section is written when it differs
+// from section of previous parameter
+//
+// Params:
+// @writer - opened writer
+// @section - name of section
+// @key - name of parameter
+// @value - value of parameter
+//
+// Return value: 1 - success, 0 - string can't be read back the same (empty,
+// surrounded by spaces, contains newline, comment or delimiter) or failed to
+// write file, next writes fail too
+//-----------------------------------------------------------------------------
+
+int ini_writer_write(struct ini_writer *writer, const char *section, const char *key, const char *value);
+
+//-----------------------------------------------------------------------------
+// Purpose: flush buffer of writer and close file
+//
+// Params:
+// @writer - opened writer
+//
+// Return value: 1 - success, 0 - some write failed
+//-----------------------------------------------------------------------------
+
+int ini_writer_close(struct ini_writer *writer);
+
+//-----------------------------------------------------------------------------
+// Purpose: write filled hash table to file, parameters are grouped by sections
+// in order of their appearance. New file is written next to the old one with
+// unique name and renamed over it, so failure leaves existing file as it was.
+// Symbolic links are followed, file they point to is replaced and keeps its mode
+//
+// Params:
+// @data - pointer to hash table
+// @filename - directory of file
+//
+// Return value: 1 - success, 0 - failed to write file
+//-----------------------------------------------------------------------------
+
+int ini_write_data(const struct ini_data *data, const char *filename);
+
+//-----------------------------------------------------------------------------
+// Purpose: replace values of parameters which differ in existing file keeping
+// comments, spaces and order of lines, missing parameters are inserted after
+// the last parameter of their section, missing sections are appended (new
+// file is written next to it and renamed like by ini_write_data)
+//
+// Params:
+// @filename - directory of file
+// @values - hash table of new values
+//
+// Return value: 1 - success, 0 - failed to parse or to write file
+//-----------------------------------------------------------------------------
+
+int ini_patch_file(const char *filename, const struct ini_data *values);
+
+//-----------------------------------------------------------------------------
+// Purpose: initialize reloader, file isn't parsed until the first reload
+//
+// Params:
+// @reloader - reloader to initialize
+// @filename - directory of file
+// @options - combination of INI_OPTION_* flags for context of reloader (with
+// INI_OPTION_MMAP file must be replaced by renaming, not rewritten in place)
+//
+// Return value: 1 - success, 0 - failed to allocate memory
+//-----------------------------------------------------------------------------
+
+int ini_reloader_init(struct ini_reloader *reloader, const char *filename, int options);
+
+//-----------------------------------------------------------------------------
+// Purpose: set function called after each reload with every added, removed and
+// modified parameter (set it before watching)
+//
+// Params:
+// @reloader - initialized reloader
+// @callback - pointer to function (NULL - no calls)
+// @context - value passed to function
+//-----------------------------------------------------------------------------
+
+void ini_reloader_set_callback(struct ini_reloader *reloader, iniChangeFn callback, void *context);
+
+//-----------------------------------------------------------------------------
+// Purpose: parse file into a new table, publish it and free the previous one
+// when its readers leave, failed parsing keeps the current table
+//
+// Params:
+// @reloader - initialized reloader
+//
+// Return value: 1 - success, 0 - failed to parse file
+//-----------------------------------------------------------------------------
+
+int ini_reloader_reload(struct ini_reloader *reloader);
+
+//-----------------------------------------------------------------------------
+// Purpose: start reloading in background thread when file changes
+//
+// Params:
+// @reloader - initialized reloader
+//
+// Return value: 1 - success, 0 - failed to create thread
+//-----------------------------------------------------------------------------
+
+int ini_reloader_watch(struct ini_reloader *reloader);
+
+//-----------------------------------------------------------------------------
+// Purpose: get current table, it stays alive until ini_reloader_release
+//
+// Params:
+// @reloader - initialized reloader
+// @ticket - receives value to pass to ini_reloader_release
+//
+// Return value: current table, release it by ini_reloader_release, or NULL if
+// file isn't loaded yet (nothing is held then, its release is optional)
+//-----------------------------------------------------------------------------
+
+struct ini_data *ini_reloader_acquire(struct ini_reloader *reloader, unsigned int *ticket);
+
+//-----------------------------------------------------------------------------
+// Purpose: finish reading of table returned by ini_reloader_acquire
+//
+// Params:
+// @reloader - initialized reloader
+// @ticket - value received from ini_reloader_acquire
+//-----------------------------------------------------------------------------
+
+void ini_reloader_release(struct ini_reloader *reloader, unsigned int ticket);
+
+//-----------------------------------------------------------------------------
+// Purpose: stop watching and free memory of reloader
+//
+// Params:
+// @reloader - initialized reloader
+//-----------------------------------------------------------------------------
+
+void ini_reloader_free(struct ini_reloader *reloader);
+
+//-----------------------------------------------------------------------------
+// Purpose: get memory usage of arena of hash table
+//
+// Params:
+// @data - pointer to hash table
+// @used - bytes given to entries and strings (can be NULL)
+// @reserved - bytes allocated for chunks of arena (can be NULL)
+//-----------------------------------------------------------------------------
+
+void ini_get_arena_usage(const struct ini_data *data, size_t *used, size_t *reserved);
+
+//-----------------------------------------------------------------------------
+// Purpose: get occupancy and lengths of probes of indices of hash table
+//
+// Params:
+// @data - pointer to hash table
+// @stats - output statistics
+//-----------------------------------------------------------------------------
+
+void ini_get_table_stats(const struct ini_data *data, struct ini_table_stats *stats);
 
 //-----------------------------------------------------------------------------
 // Purpose: free allocated memory for hash table
@@ -0,0 +1,378 @@
+/** Test of failed allocations
+*
+*	Copyright (c) 2021 Sw1ft
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+// Allocator is wrapped in GNU ld (--wrap), so the N-th allocation of library
+// fails. Each path of parsing (and loading of several files) is run with failure of its first, second, ...
+// allocation until it allocates less. Parsing must either give the whole
+// table or fail with INI_ERROR_OUT_OF_MEMORY without position, error of the
+// previous parsing must not be left
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ini_parser.h"
+
+#define TEST_FILENAME "ini_test_memory.tmp"
+
+// Sections repeat, so their entries are moved to be contiguous
+#define TEST_SECTIONS 10
+#define TEST_ENTRIES 10000
+
+// Files loaded together, each one on its own thread
+#define TEST_FILES 4
+
+// Text parsed in parallel, parts are split only after 1 MB
+#define TEST_PARALLEL_ENTRIES 150000
+
+static size_t s_checked = 0;
+static size_t s_failed = 0;
+
+static size_t s_handled = 0;
+
+//-----------------------------------------------------------------------------
+// Wrapped allocator, the allocation with number s_fail_at fails (0 - none)
+//-----------------------------------------------------------------------------
+
+static unsigned int s_allocations = 0;
+static unsigned int s_fail_at = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *memory, size_t size);
+
+static int test_is_failing()
+{
+	return s_fail_at && __atomic_add_fetch(&s_allocations, 1, __ATOMIC_RELAXED) == s_fail_at;
+}
+
+void *__wrap_malloc(size_t size)
+{
+	return test_is_failing() ? NULL : __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+	return test_is_failing() ? NULL : __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *memory, size_t size)
+{
+	return test_is_failing() ? NULL : __real_realloc(memory, size);
+}
+
+//-----------------------------------------------------------------------------
+// Text of test
+//-----------------------------------------------------------------------------
+
+typedef struct
+{
+	char *str;
+	size_t length;
+	size_t entries;
+} test_text_t;
+
+//-----------------------------------------------------------------------------
+// Purpose: generate text where sections repeat
+//-----------------------------------------------------------------------------
+
+static void test_generate(test_text_t *text, size_t entries)
+{
+	text->str = malloc(entries * 40 + 64);
+	text->length = 0;
+	text->entries = entries;
+
+	for (size_t i = 0; i < entries; ++i)
+	{
+		if (i % 100 == 0)
+			text->length += (size_t)sprintf(text->str + text->length, "[section%zu]\n", (i / 100) % TEST_SECTIONS);
+
+		text->length += (size_t)sprintf(text->str + text->length, "key%zu = value %zu\n", i, i);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: write text to file
+//-----------------------------------------------------------------------------
+
+static void test_write_file(const test_text_t *text)
+{
+	FILE *file = fopen(TEST_FILENAME, "wb");
+
+	if (!file || fwrite(text->str, 1, text->length, file) != text->length || fclose(file) != 0)
+	{
+		fprintf(stderr, "Failed to write '%s'\n", TEST_FILENAME);
+		exit(2);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: count parameters passed to handler
+//-----------------------------------------------------------------------------
+
+static void test_handler(const char *section, const char *key, const char *value)
+{
+	(void)section;
+	(void)key;
+	(void)value;
+
+	++s_handled;
+}
+
+//-----------------------------------------------------------------------------
+// Paths of parsing, they return result and count of parsed parameters
+//-----------------------------------------------------------------------------
+
+typedef int (*test_path_fn)(const test_text_t *text, size_t *count, int *error, int *line);
+
+static int test_take_data(int success, struct ini_data *data, size_t *count)
+{
+	if (success)
+	{
+		*count = data->entry_count;
+		ini_free_data(data, 0);
+	}
+
+	return success;
+}
+
+static int test_file(const test_text_t *text, size_t *count, int *error, int *line)
+{
+	struct ini_data data;
+	(void)text;
+	(void)error;
+	(void)line;
+
+	return test_take_data(ini_parse_data(TEST_FILENAME, &data), &data, count);
+}
+
+static int test_buffer(const test_text_t *text, size_t *count, int *error, int *line)
+{
+	struct ini_data data;
+	(void)error;
+	(void)line;
+
+	return test_take_data(ini_parse_buffer_data(text->str, text->length, &data), &data, count);
+}
+
+static int test_mapping(const test_text_t *text, size_t *count, int *error, int *line)
+{
+	struct ini_data data;
+	(void)text;
+	(void)error;
+	(void)line;
+
+	return test_take_data(ini_parse_mmap_data(TEST_FILENAME, &data), &data, count);
+}
+
+static int test_lazy(const test_text_t *text, size_t *count, int *error, int *line)
+{
+	struct ini_data data;
+	(void)text;
+	(void)error;
+	(void)line;
+
+	if (!ini_parse_lazy_data(TEST_FILENAME, &data))
+		return 0;
+
+	if (!ini_load_sections(&data))
+	{
+		ini_free_data(&data, 0);
+		return 0;
+	}
+
+	return test_take_data(1, &data, count);
+}
+
+static int test_parallel(const test_text_t *text, size_t *count, int *error, int *line)
+{
+	struct ini_data data;
+	(void)text;
+	(void)error;
+	(void)line;
+
+	return test_take_data(ini_parse_parallel_data(TEST_FILENAME, &data, 4), &data, count);
+}
+
+static int test_buffer_handler(const test_text_t *text, size_t *count, int *error, int *line)
+{
+	(void)error;
+	(void)line;
+
+	s_handled = 0;
+
+	int success = ini_parse_buffer_handler(text->str, text->length, test_handler);
+	*count = s_handled;
+
+	return success;
+}
+
+static int test_incremental(const test_text_t *text, size_t *count, int *error, int *line)
+{
+	struct ini_parser parser;
+	struct ini_data data;
+
+	ini_parser_init(&parser, 0);
+
+	int success = ini_parser_begin_data(&parser, &data);
+
+	// Lines are split between chunks
+	for (size_t pos = 0; success && pos < text->length; pos += 1000)
+		success = ini_parser_feed(&parser, text->str + pos, text->length - pos < 1000 ? text->length - pos : 1000);
+
+	success = success && ini_parser_finish(&parser);
+
+	*error = parser.error_code;
+	*line = parser.line;
+
+	ini_parser_free(&parser);
+
+	return test_take_data(success, &data, count);
+}
+
+static int test_files(const test_text_t *text, size_t *count, int *error, int *line)
+{
+	const char *filenames[TEST_FILES];
+	struct ini_files files;
+
+	for (int i = 0; i < TEST_FILES; ++i)
+		filenames[i] = TEST_FILENAME;
+
+	int success = ini_parse_files(filenames, TEST_FILES, &files, TEST_FILES);
+
+	*error = ini_get_last_error();
+	*line = ini_get_last_line();
+	*count = text->entries;
+
+	// Every file either has whole table or failed by allocation
+	for (size_t i = 0; i < files.count; ++i)
+	{
+		if (files.files[i].error_code == INI_NO_ERROR && files.files[i].data.entry_count != text->entries)
+			*count = files.files[i].data.entry_count;
+		else if (files.files[i].error_code != INI_NO_ERROR && (files.files[i].error_code != INI_ERROR_OUT_OF_MEMORY || files.files[i].line != -1))
+			*error = files.files[i].error_code;
+	}
+
+	if (!success && *count != text->entries)
+	{
+		printf("files: %zu of %zu parameters in file without error\n", *count, text->entries);
+		++s_failed;
+	}
+
+	ini_free_files(&files);
+
+	return success;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: fail every allocation of path in turn
+//-----------------------------------------------------------------------------
+
+static void test_path(const char *name, test_path_fn path, const test_text_t *text, int hasContext)
+{
+	size_t runs = 0, failures = 0;
+
+	for (unsigned int failAt = 1;; ++failAt)
+	{
+		// Error of previous parsing is left in default context
+		struct ini_data broken;
+		ini_parse_buffer_data("[x", 2, &broken);
+
+		size_t count = 0;
+		int error = INI_NO_ERROR;
+		int line = -1;
+
+		s_allocations = 0;
+		s_fail_at = failAt;
+
+		int success = path(text, &count, &error, &line);
+		int isInjected = (s_allocations >= failAt);
+
+		s_fail_at = 0;
+
+		if (!hasContext)
+		{
+			error = ini_get_last_error();
+			line = ini_get_last_line();
+		}
+
+		++s_checked;
+		++runs;
+
+		if (success && count != text->entries)
+		{
+			++s_failed;
+			printf("%s: allocation %u failed, %zu of %zu parameters parsed without error\n", name, failAt, count, text->entries);
+		}
+		else if (!success && (error != INI_ERROR_OUT_OF_MEMORY || line != -1))
+		{
+			++s_failed;
+			printf("%s: allocation %u failed, error %d in line %d instead of out of memory\n", name, failAt, error, line);
+		}
+
+		failures += !success;
+
+		if (!isInjected)
+		{
+			if (!success)
+			{
+				++s_failed;
+				printf("%s: failed without failed allocation\n", name);
+			}
+
+			break;
+		}
+	}
+
+	printf("%s: %zu runs, %zu failed by allocation\n", name, runs, failures);
+}
+
+int main()
+{
+	test_text_t text, large;
+
+	test_generate(&text, TEST_ENTRIES);
+	test_generate(&large, TEST_PARALLEL_ENTRIES);
+
+	test_write_file(&text);
+
+	test_path("file", test_file, &text, 0);
+	test_path("buffer", test_buffer, &text, 0);
+	test_path("mapping", test_mapping, &text, 0);
+	test_path("lazy", test_lazy, &text, 0);
+	test_path("buffer handler", test_buffer_handler, &text, 0);
+	test_path("incremental", test_incremental, &text, 1);
+	test_path("files", test_files, &text, 1);
+
+	test_write_file(&large);
+	test_path("parallel", test_parallel, &large, 0);
+
+	remove(TEST_FILENAME);
+
+	free(text.str);
+	free(large.str);
+
+	printf("%zu checks, %zu failed\n", s_checked, s_failed);
+
+	return s_failed ? 1 : 0;
+}
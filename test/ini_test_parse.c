@@ -0,0 +1,766 @@
+/** Test of parsing paths on random text
+*
+*	Copyright (c) 2021 Sw1ft
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+// Random text is parsed by a naive reference parser, which goes over every
+// line character by character, and by every path of the library: file,
+// buffer, mapping, lazy, parallel and incremental, with hash table and with
+// callback. Parameters, tables and errors (with lines and columns) must be the
+// same. The library is built once per scanner of lines (scalar, SSE2, AVX2)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ini_parser.h"
+
+#define TEST_DEFAULT_ITERATIONS 3000
+#define TEST_FILENAME "ini_test_parse.tmp"
+
+// Size of text parsed in parallel, parts are split only after 1 MB
+#define TEST_PARALLEL_SIZE (6 << 20)
+
+//-----------------------------------------------------------------------------
+// Growing text
+//-----------------------------------------------------------------------------
+
+typedef struct
+{
+	char *str;
+	size_t length;
+	size_t capacity;
+} test_text_t;
+
+//-----------------------------------------------------------------------------
+// Result of parsing: parameters in order of callbacks, dump of hash table in
+// order of sections and error
+//-----------------------------------------------------------------------------
+
+typedef struct
+{
+	test_text_t events;
+	test_text_t table;
+
+	int success;
+	int error_code;
+	int line;
+	int column;
+} test_result_t;
+
+//-----------------------------------------------------------------------------
+// Section of reference table, entries keep order of their first appearance
+//-----------------------------------------------------------------------------
+
+typedef struct
+{
+	const char *name;
+	size_t length;
+
+	size_t *entries;
+	size_t count;
+	size_t capacity;
+} test_section_t;
+
+typedef struct
+{
+	const char *key;
+	size_t key_length;
+	const char *value;
+	size_t value_length;
+} test_entry_t;
+
+static unsigned long long s_random = 0x2545F4914F6CDD1DULL;
+
+// Parameters of handler are collected here, handler has no context
+static test_text_t *s_events = NULL;
+
+static size_t s_failed = 0;
+
+//-----------------------------------------------------------------------------
+// Purpose: xorshift generator, texts are the same for the same seed
+//-----------------------------------------------------------------------------
+
+static unsigned int test_random()
+{
+	s_random ^= s_random << 13;
+	s_random ^= s_random >> 7;
+	s_random ^= s_random << 17;
+
+	return (unsigned int)(s_random >> 32);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: append bytes to text
+//-----------------------------------------------------------------------------
+
+static void test_append(test_text_t *text, const char *str, size_t length)
+{
+	if (text->length + length + 1 > text->capacity)
+	{
+		size_t capacity = text->capacity ? text->capacity : 4096;
+
+		while (capacity < text->length + length + 1)
+			capacity *= 2;
+
+		text->str = realloc(text->str, capacity);
+		text->capacity = capacity;
+
+		if (!text->str)
+		{
+			fprintf(stderr, "Out of memory\n");
+			exit(2);
+		}
+	}
+
+	memcpy(text->str + text->length, str, length);
+	text->length += length;
+	text->str[text->length] = '\0';
+}
+
+static void test_append_string(test_text_t *text, const char *str)
+{
+	test_append(text, str, strlen(str));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: append parameter to list of events, separators can't be in text
+//-----------------------------------------------------------------------------
+
+static void test_append_event(test_text_t *text, const char *section, size_t sectionLength, const char *key, size_t keyLength, const char *value, size_t valueLength)
+{
+	test_append(text, section, sectionLength);
+	test_append(text, "\x01", 1);
+	test_append(text, key, keyLength);
+	test_append(text, "\x02", 1);
+	test_append(text, value, valueLength);
+	test_append(text, "\x03", 1);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: random word, lengths around widths of blocks of scanner and longer
+// than buffer of lines
+//-----------------------------------------------------------------------------
+
+static void test_word(test_text_t *text, int canHaveSpaces)
+{
+	static const char letters[] = "abcdefghijklmnopqrstuvwxyz0123456789_.-[]";
+
+	size_t length;
+
+	switch (test_random() % 16)
+	{
+	case 0:
+		length = 14 + test_random() % 36;
+		break;
+
+	case 1:
+		length = INI_BUFFER_LENGTH - 8 + test_random() % 16;
+		break;
+
+	case 2:
+		length = INI_BUFFER_LENGTH * 2 + test_random() % INI_BUFFER_LENGTH;
+		break;
+
+	default:
+		length = 1 + test_random() % 8;
+		break;
+	}
+
+	for (size_t i = 0; i < length; ++i)
+	{
+		char ch = letters[test_random() % (sizeof(letters) - 1)];
+
+		if (canHaveSpaces && i > 0 && i + 1 < length && test_random() % 6 == 0)
+			ch = (test_random() & 1) ? ' ' : '\t';
+
+		// Key can't look like section
+		if (i == 0 && ch == '[')
+			ch = 'x';
+
+		test_append(text, &ch, 1);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: random spaces
+//-----------------------------------------------------------------------------
+
+static void test_spaces(test_text_t *text)
+{
+	static const char *spaces[] = { "", "", "", " ", "  ", "\t", " \t ", "\r", "                                  " };
+	test_append_string(text, spaces[test_random() % (sizeof(spaces) / sizeof(spaces[0]))]);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: random line of mostly valid text, rarely damaged
+//-----------------------------------------------------------------------------
+
+static void test_line(test_text_t *text, int errorRate)
+{
+	static const char noise[] = "ab =;#[]\t\r ";
+	unsigned int kind = test_random() % 20;
+
+	test_spaces(text);
+
+	if (errorRate && test_random() % errorRate == 0)
+	{
+		// Anything, most likely an error
+		for (size_t i = 1 + test_random() % 40; i > 0; --i)
+			test_append(text, &noise[test_random() % (sizeof(noise) - 1)], 1);
+	}
+	else if (kind < 3)
+	{
+		test_append_string(text, "[");
+		test_spaces(text);
+		test_word(text, 1);
+		test_spaces(text);
+		test_append_string(text, "]");
+	}
+	else if (kind < 5)
+	{
+		// Comment or nothing
+		if (test_random() & 1)
+		{
+			test_append_string(text, (test_random() & 1) ? ";" : "#");
+			test_word(text, 1);
+		}
+	}
+	else
+	{
+		// Delimiters in front of key and repeated delimiters are skipped
+		if (kind == 5)
+			test_append_string(text, "=");
+
+		test_word(text, 1);
+		test_spaces(text);
+		test_append_string(text, (kind == 6) ? "==" : "=");
+		test_spaces(text);
+		test_word(text, 1);
+
+		// Text after the next delimiter is ignored
+		if (kind == 7)
+		{
+			test_append_string(text, "=");
+			test_word(text, 0);
+		}
+	}
+
+	test_spaces(text);
+
+	// Inline comment
+	if (test_random() % 8 == 0)
+	{
+		test_append_string(text, (test_random() & 1) ? " ; " : "#");
+		test_word(text, 1);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: random text starting with section, the last line may have no end
+//-----------------------------------------------------------------------------
+
+static void test_generate(test_text_t *text, size_t size, int errorRate)
+{
+	text->length = 0;
+
+	test_append_string(text, "[first]\n");
+
+	while (text->length < size)
+	{
+		test_line(text, errorRate);
+		test_append_string(text, (test_random() % 10 == 0) ? "\r\n" : "\n");
+	}
+
+	if (test_random() & 1)
+		test_line(text, errorRate);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: character which is stripped around strings
+//-----------------------------------------------------------------------------
+
+static int test_is_space(char ch)
+{
+	return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: remember error of reference parser
+//-----------------------------------------------------------------------------
+
+static void test_reference_error(test_result_t *result, int error, int line, size_t column)
+{
+	result->success = 0;
+	result->error_code = error;
+	result->line = line;
+	result->column = (int)column + 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: find section of reference table by name
+//-----------------------------------------------------------------------------
+
+static test_section_t *test_reference_section(test_section_t **sections, size_t *count, const char *name, size_t length)
+{
+	for (size_t i = 0; i < *count; ++i)
+	{
+		if ((*sections)[i].length == length && !memcmp((*sections)[i].name, name, length))
+			return &(*sections)[i];
+	}
+
+	*sections = realloc(*sections, (*count + 1) * sizeof(test_section_t));
+
+	test_section_t *section = &(*sections)[(*count)++];
+	memset(section, 0, sizeof(test_section_t));
+
+	section->name = name;
+	section->length = length;
+
+	return section;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: parse text line by line and character by character, the same rules
+// as of library: comment ends line, the first non-empty line is section,
+// key ends on the first delimiter and value on the next one
+//-----------------------------------------------------------------------------
+
+static void test_reference(const char *str, size_t length, test_result_t *result)
+{
+	test_section_t *sections = NULL;
+	size_t sectionCount = 0;
+
+	test_entry_t *entries = NULL;
+	size_t entryCount = 0;
+
+	test_section_t *section = NULL;
+	int parsingSection = 1;
+	int line = 0;
+
+	result->success = 1;
+
+	for (size_t pos = 0; pos < length;)
+	{
+		size_t lineStart = pos;
+		size_t lineEnd = pos;
+
+		while (lineEnd < length && str[lineEnd] != '\n')
+			++lineEnd;
+
+		pos = (lineEnd < length) ? lineEnd + 1 : length;
+		++line;
+
+		size_t cut = lineStart;
+
+		while (cut < lineEnd && str[cut] != ';' && str[cut] != '#')
+			++cut;
+
+		size_t begin = lineStart;
+		size_t end = cut;
+
+		while (begin < end && test_is_space(str[begin]))
+			++begin;
+
+		while (end > begin && test_is_space(str[end - 1]))
+			--end;
+
+		if (begin == end)
+			continue;
+
+		if (str[begin] == '[')
+			parsingSection = 1;
+
+		if (parsingSection)
+		{
+			if (str[begin] != '[')
+			{
+				test_reference_error(result, INI_ERROR_SECTION_START_ID, line, begin - lineStart);
+				break;
+			}
+
+			if (begin + 1 == end || str[end - 1] != ']')
+			{
+				test_reference_error(result, INI_ERROR_SECTION_END_ID, line, end - lineStart);
+				break;
+			}
+
+			size_t nameStart = begin + 1;
+			size_t nameEnd = end - 1;
+
+			while (nameStart < nameEnd && test_is_space(str[nameStart]))
+				++nameStart;
+
+			while (nameEnd > nameStart && test_is_space(str[nameEnd - 1]))
+				--nameEnd;
+
+			if (nameStart == nameEnd)
+			{
+				test_reference_error(result, INI_ERROR_SECTION_EMPTY, line, begin - lineStart);
+				break;
+			}
+
+			section = test_reference_section(&sections, &sectionCount, str + nameStart, nameEnd - nameStart);
+			parsingSection = 0;
+			continue;
+		}
+
+		size_t key = begin;
+
+		while (key < end && str[key] == '=')
+			++key;
+
+		if (key == end)
+		{
+			test_reference_error(result, INI_ERROR_KEY_EMPTY, line, key - lineStart);
+			break;
+		}
+
+		size_t keyEnd = key;
+
+		while (keyEnd < end && str[keyEnd] != '=')
+			++keyEnd;
+
+		size_t value = keyEnd;
+
+		while (value < end && str[value] == '=')
+			++value;
+
+		if (value == end)
+		{
+			test_reference_error(result, INI_ERROR_VALUE_EMPTY, line, value - lineStart);
+			break;
+		}
+
+		size_t valueEnd = value;
+
+		while (valueEnd < end && str[valueEnd] != '=')
+			++valueEnd;
+
+		while (keyEnd > key && test_is_space(str[keyEnd - 1]))
+			--keyEnd;
+
+		while (value < valueEnd && test_is_space(str[value]))
+			++value;
+
+		while (valueEnd > value && test_is_space(str[valueEnd - 1]))
+			--valueEnd;
+
+		test_append_event(&result->events, section->name, section->length, str + key, keyEnd - key, str + value, valueEnd - value);
+
+		// Repeated key replaces value
+		size_t i = 0;
+
+		for (; i < section->count; ++i)
+		{
+			test_entry_t *entry = &entries[section->entries[i]];
+
+			if (entry->key_length == keyEnd - key && !memcmp(entry->key, str + key, keyEnd - key))
+				break;
+		}
+
+		if (i == section->count)
+		{
+			entries = realloc(entries, (entryCount + 1) * sizeof(test_entry_t));
+			entries[entryCount].key = str + key;
+			entries[entryCount].key_length = keyEnd - key;
+
+			if (section->count == section->capacity)
+			{
+				section->capacity = section->capacity ? section->capacity * 2 : 8;
+				section->entries = realloc(section->entries, section->capacity * sizeof(size_t));
+			}
+
+			section->entries[section->count++] = entryCount++;
+		}
+
+		entries[section->entries[i]].value = str + value;
+		entries[section->entries[i]].value_length = valueEnd - value;
+	}
+
+	if (result->success)
+	{
+		for (size_t i = 0; i < sectionCount; ++i)
+		{
+			test_append(&result->table, "[", 1);
+			test_append(&result->table, sections[i].name, sections[i].length);
+			test_append(&result->table, "]\n", 2);
+
+			for (size_t j = 0; j < sections[i].count; ++j)
+			{
+				const test_entry_t *entry = &entries[sections[i].entries[j]];
+				test_append_event(&result->table, "", 0, entry->key, entry->key_length, entry->value, entry->value_length);
+			}
+		}
+	}
+
+	for (size_t i = 0; i < sectionCount; ++i)
+		free(sections[i].entries);
+
+	free(sections);
+	free(entries);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: collect parameter passed to handler
+//-----------------------------------------------------------------------------
+
+static void test_handler(const char *pszSection, const char *pszKey, const char *pszValue)
+{
+	test_append_event(s_events, pszSection, strlen(pszSection), pszKey, strlen(pszKey), pszValue, strlen(pszValue));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: dump hash table in order of sections, strings may not be terminated
+//-----------------------------------------------------------------------------
+
+static void test_dump(const struct ini_data *data, test_text_t *table)
+{
+	for (size_t i = 0; i < data->section_count; ++i)
+	{
+		const struct ini_section *section = data->sections[i];
+
+		test_append(table, "[", 1);
+		test_append(table, section->name, section->length);
+		test_append(table, "]\n", 2);
+
+		size_t count;
+		const struct ini_entry *entries = ini_get_entries(data, section, &count);
+
+		for (size_t j = 0; j < count; ++j)
+			test_append_event(table, "", 0, entries[j].key, entries[j].key_length, entries[j].value, entries[j].value_length);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: take error of context after parsing
+//-----------------------------------------------------------------------------
+
+static void test_take_error(test_result_t *result, int success, const struct ini_parser *parser)
+{
+	result->success = success;
+	result->error_code = parser ? parser->error_code : ini_get_last_error();
+	result->line = parser ? parser->line : ini_get_last_line();
+	result->column = parser ? parser->column : ini_get_last_column();
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: compare result of path with expected one
+//-----------------------------------------------------------------------------
+
+static void test_compare(const char *path, const test_result_t *expected, const test_result_t *result, int hasEvents, size_t iteration)
+{
+	const char *problem = NULL;
+
+	if (result->success != expected->success)
+		problem = "success";
+	else if (!expected->success && (result->error_code != expected->error_code || result->line != expected->line || result->column != expected->column))
+		problem = "error";
+	// Empty text may have no buffer, memcmp isn't called with NULL
+	else if (hasEvents && (result->events.length != expected->events.length || (expected->events.length && memcmp(result->events.str, expected->events.str, expected->events.length))))
+		problem = "parameters";
+	else if (!hasEvents && expected->success && (result->table.length != expected->table.length || (expected->table.length && memcmp(result->table.str, expected->table.str, expected->table.length))))
+		problem = "hash table";
+
+	if (!problem)
+		return;
+
+	if (++s_failed <= 20)
+	{
+		printf("text %zu, %s: different %s (expected %d, error %d at %d:%d; got %d, error %d at %d:%d)\n", iteration, path, problem,
+			expected->success, expected->error_code, expected->line, expected->column,
+			result->success, result->error_code, result->line, result->column);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: reset result of path
+//-----------------------------------------------------------------------------
+
+static void test_reset(test_result_t *result)
+{
+	result->events.length = 0;
+	result->table.length = 0;
+	result->success = 0;
+	result->error_code = INI_NO_ERROR;
+	result->line = 0;
+	result->column = 0;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: check hash table filled by path
+//-----------------------------------------------------------------------------
+
+static void test_data(const char *path, const test_result_t *expected, test_result_t *result, struct ini_data *data, size_t iteration)
+{
+	if (result->success)
+		test_dump(data, &result->table);
+
+	test_compare(path, expected, result, 0, iteration);
+
+	if (result->success)
+		ini_free_data(data, 0);
+
+	test_reset(result);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: feed text in chunks of random sizes
+//-----------------------------------------------------------------------------
+
+static int test_feed(struct ini_parser *parser, const test_text_t *text)
+{
+	for (size_t pos = 0; pos < text->length;)
+	{
+		size_t length = 1 + test_random() % 100;
+
+		if (length > text->length - pos)
+			length = text->length - pos;
+
+		if (!ini_parser_feed(parser, text->str + pos, length))
+			return 0;
+
+		pos += length;
+	}
+
+	return ini_parser_finish(parser);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: parse text by every path and compare with reference
+//-----------------------------------------------------------------------------
+
+static void test_text(const test_text_t *text, size_t iteration, int threads)
+{
+	test_result_t expected, result;
+	struct ini_data data;
+	struct ini_parser parser;
+
+	memset(&expected, 0, sizeof(expected));
+	memset(&result, 0, sizeof(result));
+
+	test_reference(text->str, text->length, &expected);
+
+	FILE *file = fopen(TEST_FILENAME, "wb");
+
+	if (!file || fwrite(text->str, 1, text->length, file) != text->length || fclose(file) != 0)
+	{
+		fprintf(stderr, "Failed to write '%s'\n", TEST_FILENAME);
+		exit(2);
+	}
+
+	// Hash tables
+	test_take_error(&result, ini_parse_data(TEST_FILENAME, &data), NULL);
+	test_data("file", &expected, &result, &data, iteration);
+
+	test_take_error(&result, ini_parse_buffer_data(text->str, text->length, &data), NULL);
+	test_data("buffer", &expected, &result, &data, iteration);
+
+	test_take_error(&result, ini_parse_mmap_data(TEST_FILENAME, &data), NULL);
+	test_data("mapping", &expected, &result, &data, iteration);
+
+	int success = ini_parse_lazy_data(TEST_FILENAME, &data);
+
+	if (success && !ini_load_sections(&data))
+	{
+		ini_free_data(&data, 0);
+		success = 0;
+	}
+
+	test_take_error(&result, success, NULL);
+	test_data("lazy", &expected, &result, &data, iteration);
+
+	test_take_error(&result, ini_parse_parallel_data(TEST_FILENAME, &data, threads), NULL);
+	test_data("parallel", &expected, &result, &data, iteration);
+
+	ini_parser_init(&parser, INI_OPTION_REFERENCE);
+	test_take_error(&result, ini_parser_parse_buffer_data(&parser, text->str, text->length, &data), &parser);
+	test_data("buffer without copies", &expected, &result, &data, iteration);
+	ini_parser_free(&parser);
+
+	ini_parser_init(&parser, 0);
+	test_take_error(&result, ini_parser_begin_data(&parser, &data) && test_feed(&parser, text), &parser);
+	test_data("incremental", &expected, &result, &data, iteration);
+	ini_parser_free(&parser);
+
+	// Callbacks
+	s_events = &result.events;
+
+	test_take_error(&result, ini_parse_handler(TEST_FILENAME, test_handler), NULL);
+	test_compare("file handler", &expected, &result, 1, iteration);
+	test_reset(&result);
+
+	test_take_error(&result, ini_parse_buffer_handler(text->str, text->length, test_handler), NULL);
+	test_compare("buffer handler", &expected, &result, 1, iteration);
+	test_reset(&result);
+
+	test_take_error(&result, ini_parse_mmap_handler(TEST_FILENAME, test_handler), NULL);
+	test_compare("mapping handler", &expected, &result, 1, iteration);
+	test_reset(&result);
+
+	ini_parser_init(&parser, 0);
+	test_take_error(&result, ini_parser_begin_handler(&parser, test_handler) && test_feed(&parser, text), &parser);
+	test_compare("incremental handler", &expected, &result, 1, iteration);
+	ini_parser_free(&parser);
+
+	s_events = NULL;
+
+	free(expected.events.str);
+	free(expected.table.str);
+	free(result.events.str);
+	free(result.table.str);
+}
+
+int main(int argc, char **argv)
+{
+	size_t iterations = (argc > 1) ? strtoull(argv[1], NULL, 10) : TEST_DEFAULT_ITERATIONS;
+
+	if (argc > 2)
+		s_random = (strtoull(argv[2], NULL, 10) * 0x9E3779B97F4A7C15ULL) | 1;
+
+	test_text_t text;
+	memset(&text, 0, sizeof(text));
+
+	// Small texts, some of them with errors
+	for (size_t i = 0; i < iterations; ++i)
+	{
+		test_generate(&text, test_random() % 2000, (i % 4 == 0) ? 0 : 40);
+		test_text(&text, i, 4);
+	}
+
+	// Large texts split in parts, the last one with error somewhere in its end
+	for (size_t i = 0; i < 3; ++i)
+	{
+		test_generate(&text, TEST_PARALLEL_SIZE, 0);
+
+		if (i == 2)
+			test_append_string(&text, "\n[broken\n");
+
+		test_text(&text, iterations + i, 4);
+	}
+
+	remove(TEST_FILENAME);
+	free(text.str);
+
+	printf("%zu texts, %zu failed\n", iterations + 3, s_failed);
+
+	return s_failed ? 1 : 0;
+}
@@ -0,0 +1,278 @@
+/** Test of conversion of real numbers
+*
+*	Copyright (c) 2021 Sw1ft
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+// Results are compared with strtod / strtof of C library in "C" locale, which
+// must round correctly (glibc, musl and recent CRT of MSVC do)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+
+#include "ini_parser.h"
+
+#define TEST_DEFAULT_ITERATIONS 100000
+
+// Longer than digits kept exactly by conversion
+#define TEST_LONG_DIGITS 1100
+
+static unsigned long long s_random = 0x2545F4914F6CDD1DULL;
+
+static size_t s_checked = 0;
+static size_t s_failed = 0;
+
+//-----------------------------------------------------------------------------
+// Values which are hard to round: subnormals, halfway cases, bounds of types
+//-----------------------------------------------------------------------------
+
+static const char *s_edges[] =
+{
+	"0", "-0", "0.0e10", "1", "0.1", "0.2", "0.3", "0.30000000000000004", "3.14159265358979323846264338327950288",
+	"1e23", "8.589973e9", "9007199254740993", "9007199254740992.5", "9007199254740993.0000000001",
+	"123456789012345678901234567890e-30", "0.000000000000000000000000000000000000001",
+
+	// Subnormals and the smallest numbers
+	"4.9406564584124654e-324", "2.4703282292062327e-324", "2.4703282292062328e-324", "1e-324", "5e-324",
+	"2.2250738585072011e-308", "2.2250738585072012e-308", "2.2250738585072014e-308", "1e-400",
+	"1.4e-45", "7e-46", "7.1e-46", "1.17549435e-38", "1.1754942e-38",
+
+	// The largest numbers and overflow
+	"1.7976931348623157e308", "1.7976931348623158e308", "1.797693134862315807e308", "1.7976931348623159e308", "1e309",
+	"3.4028234e38", "3.4028235e38", "3.40282356e38", "3.4028236e38", "1e39", "-1e400",
+
+	// Halfway cases of float and double
+	"1.00000005960464477539062499", "1.000000059604644775390625", "1.00000005960464477539062501",
+	"0.500000000000000166533453693773481063544750213623046875",
+	"9007199254740993", "9007199254740995", "18014398509481986", "18014398509481990",
+
+	// Long mantissas
+	"0.1000000000000000055511151231257827021181583404541015625",
+	"0.1000000000000000055511151231257827021181583404541015624",
+	"0.1000000000000000055511151231257827021181583404541015626",
+	"2.4703282292062327208828439643411068618252990130716238221279284125033775363510437593264991818081799618989828234772285886546332835517796989819938739800539093906315035659515570226392290858392449105184435931802849936536152500319370457678249219365623669863658480757001585769269903706311928279558551332927834338409351978015531246597263579574622766465272827220056374006485499977096599470454020828166226237857393450736339007967761930577506740176324673600968951340535537458516661134223766678604162159680461914467291840300530057530849048765391711386591646239524912623653881879636239373280423891018672348497668235089863388587925628302755995657524455507255189313690836254779186948667994968324049705821028513185451396213837722826145437693412532098591327667236328125e-324"
+};
+
+//-----------------------------------------------------------------------------
+// Purpose: xorshift generator, inputs are the same for the same seed
+//-----------------------------------------------------------------------------
+
+static unsigned long long test_random()
+{
+	s_random ^= s_random << 13;
+	s_random ^= s_random >> 7;
+	s_random ^= s_random << 17;
+
+	return s_random;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: convert string as double and float, compare with C library
+//-----------------------------------------------------------------------------
+
+static void test_check(const char *str)
+{
+	struct ini_datatype datatype;
+
+	double expectedDouble = strtod(str, NULL);
+	float expectedFloat = strtof(str, NULL);
+
+	++s_checked;
+
+	// Overflow fails, everything else is exactly the same as of C library
+	int success = ini_read_string(str, &datatype, INI_FIELD_DOUBLE);
+
+	if (isinf(expectedDouble) ? (success || ini_get_last_error() != INI_ERROR_OUT_OF_RANGE) : (!success || memcmp(&datatype.m_double, &expectedDouble, sizeof(double))))
+	{
+		if (++s_failed <= 20)
+			printf("double '%.80s': expected %.17g, got %.17g (success %d)\n", str, expectedDouble, success ? datatype.m_double : 0.0, success);
+	}
+
+	success = ini_read_string(str, &datatype, INI_FIELD_FLOAT);
+
+	if (isinf(expectedFloat) ? (success || ini_get_last_error() != INI_ERROR_OUT_OF_RANGE) : (!success || memcmp(&datatype.m_float, &expectedFloat, sizeof(float))))
+	{
+		if (++s_failed <= 20)
+			printf("float '%.80s': expected %.9g, got %.9g (success %d)\n", str, expectedFloat, success ? datatype.m_float : 0.0f, success);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: random double or float printed with random precision
+//-----------------------------------------------------------------------------
+
+static void test_printed(char *buffer, int isFloat)
+{
+	if (isFloat)
+	{
+		unsigned int bits = (unsigned int)test_random();
+		float value;
+
+		memcpy(&value, &bits, sizeof(float));
+
+		if (isfinite(value))
+			sprintf(buffer, "%.*g", 1 + (int)(test_random() % 12), value);
+		else
+			strcpy(buffer, "1.5");
+	}
+	else
+	{
+		unsigned long long bits = test_random();
+		double value;
+
+		memcpy(&value, &bits, sizeof(double));
+
+		if (isfinite(value))
+			sprintf(buffer, "%.*g", 1 + (int)(test_random() % 20), value);
+		else
+			strcpy(buffer, "2.5");
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: random digits with optional fraction and exponent
+//-----------------------------------------------------------------------------
+
+static void test_digits(char *buffer, size_t maxDigits)
+{
+	size_t length = 0;
+
+	if (test_random() & 1)
+		buffer[length++] = '-';
+
+	size_t count = 1 + test_random() % maxDigits;
+
+	for (size_t i = 0; i < count; ++i)
+		buffer[length++] = (char)('0' + test_random() % 10);
+
+	if (test_random() & 1)
+	{
+		buffer[length++] = '.';
+
+		for (size_t i = test_random() % 30; i > 0; --i)
+			buffer[length++] = (char)('0' + test_random() % 10);
+	}
+
+	sprintf(buffer + length, "e%d", (int)(test_random() % 700) - 350 - (int)count);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: exact decimal of the middle between two neighbouring doubles (or
+// floats), optionally moved a bit above the middle by the last digit
+//-----------------------------------------------------------------------------
+
+static void test_halfway(char *buffer, size_t size, int isFloat, int isAbove)
+{
+	int length;
+
+	if (isFloat)
+	{
+		// Not the largest float, next one would be infinity
+		unsigned int bits = (unsigned int)test_random() & 0x7F7FFFFEu;
+		float value;
+
+		memcpy(&value, &bits, sizeof(float));
+
+		// Middle of floats fits in double exactly, printf prints it exactly with enough digits
+		double middle = ((double)value + (double)nextafterf(value, INFINITY)) / 2;
+		length = snprintf(buffer, size, "%.*e", (int)size - 32, middle);
+	}
+	else
+	{
+#if LDBL_MANT_DIG >= 64
+		unsigned long long bits = test_random() & 0x7FEFFFFFFFFFFFFEULL;
+		double value;
+
+		memcpy(&value, &bits, sizeof(double));
+
+		long double middle = ((long double)value + (long double)nextafter(value, INFINITY)) / 2;
+		length = snprintf(buffer, size, "%.*Le", (int)size - 32, middle);
+#else
+		// Middle of doubles can't be computed exactly without wider type
+		test_printed(buffer, 0);
+		return;
+#endif
+	}
+
+	if (!isAbove)
+		return;
+
+	// Digits behind the exact value are zeros, the last one makes value a bit bigger
+	char *exponent = strchr(buffer, 'e');
+
+	if (exponent && exponent > buffer && length > 0)
+		exponent[-1] = '1';
+}
+
+int main(int argc, char **argv)
+{
+	size_t iterations = (argc > 1) ? strtoull(argv[1], NULL, 10) : TEST_DEFAULT_ITERATIONS;
+
+	if (argc > 2)
+		s_random = (strtoull(argv[2], NULL, 10) * 0x9E3779B97F4A7C15ULL) | 1;
+
+	static char buffer[TEST_LONG_DIGITS + 64];
+
+	for (size_t i = 0; i < sizeof(s_edges) / sizeof(s_edges[0]); ++i)
+		test_check(s_edges[i]);
+
+	for (size_t i = 0; i < iterations; ++i)
+	{
+		switch (i % 8)
+		{
+		case 0:
+		case 1:
+			test_printed(buffer, (int)(i % 2));
+			break;
+
+		case 2:
+			test_digits(buffer, 40);
+			break;
+
+		case 3:
+			test_digits(buffer, TEST_LONG_DIGITS);
+			break;
+
+		case 4:
+		case 5:
+			// Exact middle is rounded to even
+			test_halfway(buffer, 800, (int)(i % 2), 0);
+			break;
+
+		case 6:
+			test_halfway(buffer, 800, (int)(test_random() & 1), 1);
+			break;
+
+		default:
+			// The only non-zero digit behind the middle is after digits kept exactly
+			test_halfway(buffer, sizeof(buffer), (int)(test_random() & 1), 1);
+			break;
+		}
+
+		test_check(buffer);
+	}
+
+	printf("%zu values, %zu failed\n", s_checked, s_failed);
+
+	return s_failed ? 1 : 0;
+}
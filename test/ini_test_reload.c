@@ -0,0 +1,217 @@
+/** Test of reloader
+*
+*	Copyright (c) 2021 Sw1ft
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+// Readers acquire and release tables on several threads while the main one
+// rewrites file and reloads it. Every acquired table must be whole (two values
+// written together are equal) and versions seen by a reader never go back.
+// Readers start before the first reload and don't release NULL, which must
+// not block reloading. Changes reported by callback are counted
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "ini_parser.h"
+
+#define TEST_FILENAME "ini_test_reload.tmp"
+#define TEST_TEMPORARY_FILENAME "ini_test_reload_new.tmp"
+
+#define TEST_READERS 4
+#define TEST_RELOADS 100
+
+static size_t s_failed = 0;
+
+static volatile int s_is_done = 0;
+
+// Counters of reported changes, callback runs under lock of reloader
+static size_t s_added = 0;
+static size_t s_modified = 0;
+static size_t s_other = 0;
+
+//-----------------------------------------------------------------------------
+// Result of reader thread
+//-----------------------------------------------------------------------------
+
+typedef struct
+{
+	struct ini_reloader *reloader;
+
+	size_t reads;
+	size_t empty;
+	size_t failed;
+} test_reader_t;
+
+//-----------------------------------------------------------------------------
+// Purpose: replace file by new version at once
+//-----------------------------------------------------------------------------
+
+static void test_write_version(int version)
+{
+	FILE *file = fopen(TEST_TEMPORARY_FILENAME, "wb");
+
+	if (!file || fprintf(file, "[s]\nversion = %d\nmirror = %d\n", version, version) < 0 || fclose(file) != 0 ||
+		rename(TEST_TEMPORARY_FILENAME, TEST_FILENAME) != 0)
+	{
+		fprintf(stderr, "Failed to write '%s'\n", TEST_FILENAME);
+		exit(2);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: count changes reported after reload
+//-----------------------------------------------------------------------------
+
+static void test_on_change(void *context, int change, const struct ini_entry *previous, const struct ini_entry *current)
+{
+	(void)context;
+	(void)previous;
+	(void)current;
+
+	if (change == INI_CHANGE_ADDED)
+		++s_added;
+	else if (change == INI_CHANGE_MODIFIED)
+		++s_modified;
+	else
+		++s_other;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: read tables until reloading is done
+//-----------------------------------------------------------------------------
+
+static void *test_reader(void *parameter)
+{
+	test_reader_t *reader = (test_reader_t *)parameter;
+	long long lastVersion = -1;
+
+	while (!__atomic_load_n(&s_is_done, __ATOMIC_ACQUIRE))
+	{
+		unsigned int ticket;
+		struct ini_data *data = ini_reloader_acquire(reader->reloader, &ticket);
+
+		// Nothing is held without table
+		if (!data)
+		{
+			++reader->empty;
+			continue;
+		}
+
+		struct ini_datatype version, mirror;
+
+		int success = ini_read_data(data, "s", "version", &version, INI_FIELD_INT64) &&
+			ini_read_data(data, "s", "mirror", &mirror, INI_FIELD_INT64);
+
+		if (!success || version.m_int64 != mirror.m_int64 || version.m_int64 < lastVersion)
+			++reader->failed;
+		else
+			lastVersion = version.m_int64;
+
+		++reader->reads;
+
+		ini_reloader_release(reader->reloader, ticket);
+	}
+
+	return NULL;
+}
+
+int main()
+{
+	struct ini_reloader reloader;
+	test_reader_t readers[TEST_READERS];
+	pthread_t threads[TEST_READERS];
+
+	test_write_version(0);
+
+	if (!ini_reloader_init(&reloader, TEST_FILENAME, 0))
+	{
+		fprintf(stderr, "Failed to initialize reloader\n");
+		return 2;
+	}
+
+	ini_reloader_set_callback(&reloader, test_on_change, NULL);
+
+	// File isn't loaded yet, NULL isn't released and mustn't block reloading
+	unsigned int ticket;
+
+	if (ini_reloader_acquire(&reloader, &ticket))
+	{
+		printf("acquire before reload: got table\n");
+		++s_failed;
+	}
+
+	for (int i = 0; i < TEST_READERS; ++i)
+	{
+		memset(&readers[i], 0, sizeof(test_reader_t));
+		readers[i].reloader = &reloader;
+
+		if (pthread_create(&threads[i], NULL, test_reader, &readers[i]) != 0)
+		{
+			fprintf(stderr, "Failed to create thread\n");
+			return 2;
+		}
+	}
+
+	size_t failedReloads = 0;
+
+	for (int version = 0; version < TEST_RELOADS; ++version)
+	{
+		if (version > 0)
+			test_write_version(version);
+
+		if (!ini_reloader_reload(&reloader))
+			++failedReloads;
+	}
+
+	__atomic_store_n(&s_is_done, 1, __ATOMIC_RELEASE);
+
+	size_t reads = 0, empty = 0;
+
+	for (int i = 0; i < TEST_READERS; ++i)
+	{
+		pthread_join(threads[i], NULL);
+
+		reads += readers[i].reads;
+		empty += readers[i].empty;
+		s_failed += readers[i].failed;
+	}
+
+	if (s_failed)
+		printf("reads: %zu tables torn or older than already seen\n", s_failed);
+
+	if (failedReloads)
+		printf("reload: %zu failed\n", failedReloads);
+
+	// The first reload adds both values, next ones modify both
+	if (s_added != 2 || s_modified != 2 * (TEST_RELOADS - 1) || s_other)
+		printf("changes: added %zu, modified %zu, other %zu\n", s_added, s_modified, s_other);
+
+	s_failed += failedReloads + (s_added != 2 || s_modified != 2 * (TEST_RELOADS - 1) || s_other);
+
+	ini_reloader_free(&reloader);
+	remove(TEST_FILENAME);
+
+	printf("%d reloads, %zu reads, %zu empty, %zu failed\n", TEST_RELOADS, reads, empty, s_failed);
+
+	return s_failed ? 1 : 0;
+}
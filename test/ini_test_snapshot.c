@@ -0,0 +1,272 @@
+/** Test of binary snapshots
+*
+*	Copyright (c) 2021 Sw1ft
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+// Saved table is loaded back and every parameter is read from the mapping.
+// Damaged images must be rejected: truncated, with other version and with
+// index without empty slot (checksum recomputed, so only validation of slots
+// stops endless probing). Source of library is included to reach layout of
+// snapshot and its checksum
+
+#include "ini_parser.c"
+
+#define TEST_FILENAME "ini_test_snapshot.tmp"
+
+#define TEST_SECTIONS 8
+#define TEST_KEYS 50
+
+static size_t s_checked = 0;
+static size_t s_failed = 0;
+
+//-----------------------------------------------------------------------------
+// Purpose: count check, print failed one
+//-----------------------------------------------------------------------------
+
+static void test_check(const char *name, int success)
+{
+	++s_checked;
+
+	if (!success)
+	{
+		++s_failed;
+		printf("%s: failed (error '%s')\n", name, ini_get_last_error_msg());
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: read whole file
+//-----------------------------------------------------------------------------
+
+static char *test_read_file(const char *filename, size_t *size)
+{
+	FILE *file = fopen(filename, "rb");
+	char *image = NULL;
+
+	if (file && fseek(file, 0, SEEK_END) == 0)
+	{
+		long length = ftell(file);
+
+		if (length > 0 && fseek(file, 0, SEEK_SET) == 0 && (image = malloc((size_t)length)) && fread(image, 1, (size_t)length, file) != (size_t)length)
+		{
+			free(image);
+			image = NULL;
+		}
+
+		*size = (size_t)length;
+	}
+
+	if (file)
+		fclose(file);
+
+	if (!image)
+	{
+		fprintf(stderr, "Failed to read '%s'\n", filename);
+		exit(2);
+	}
+
+	return image;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: write image to file, checksum is recomputed optionally
+//-----------------------------------------------------------------------------
+
+static void test_write_image(char *image, size_t size, int isChecksummed)
+{
+	if (isChecksummed)
+	{
+		ini_snapshot_header_t header;
+
+		memcpy(&header, image, sizeof(header));
+		header.checksum = ini_hash(image + sizeof(header), size - sizeof(header), 0);
+		memcpy(image, &header, sizeof(header));
+	}
+
+	FILE *file = fopen(TEST_FILENAME, "wb");
+
+	if (!file || fwrite(image, 1, size, file) != size || fclose(file) != 0)
+	{
+		fprintf(stderr, "Failed to write '%s'\n", TEST_FILENAME);
+		exit(2);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: loading of written image must fail as damaged snapshot
+//-----------------------------------------------------------------------------
+
+static void test_rejected(const char *name)
+{
+	struct ini_data data;
+
+	int success = ini_load_snapshot(TEST_FILENAME, &data);
+
+	test_check(name, !success && ini_get_last_error() == INI_ERROR_INVALID_SNAPSHOT);
+
+	if (success)
+		ini_free_data(&data, 0);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: saved table is loaded with every parameter, missing ones aren't found
+//-----------------------------------------------------------------------------
+
+static void test_round_trip(const struct ini_data *source)
+{
+	struct ini_data data;
+	char section[32], key[32], expected[32], value[32];
+
+	test_check("save", ini_save_snapshot(source, TEST_FILENAME));
+
+	if (!ini_load_snapshot(TEST_FILENAME, &data))
+	{
+		test_check("load", 0);
+		return;
+	}
+
+	int found = 1;
+
+	for (int i = 0; i < TEST_SECTIONS; ++i)
+	{
+		for (int j = 0; j < TEST_KEYS; ++j)
+		{
+			sprintf(section, "section%d", i);
+			sprintf(key, "key%d", j);
+			sprintf(expected, "value %d %d", i, j);
+
+			if (!ini_copy_data(&data, section, key, value, sizeof(value), NULL) || strcmp(value, expected))
+				found = 0;
+		}
+	}
+
+	test_check("read loaded", found);
+	test_check("read missing key", !ini_copy_data(&data, "section0", "missing", value, sizeof(value), NULL));
+	test_check("read missing section", !ini_copy_data(&data, "missing", "key0", value, sizeof(value), NULL));
+
+	ini_free_data(&data, 0);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: damaged copies of saved image are rejected
+//-----------------------------------------------------------------------------
+
+static void test_damaged()
+{
+	struct ini_data data;
+	ini_snapshot_header_t header;
+	size_t size;
+
+	char *image = test_read_file(TEST_FILENAME, &size);
+	char *copy = malloc(size);
+
+	memcpy(&header, image, sizeof(header));
+
+	// Recomputed checksum alone doesn't break image
+	memcpy(copy, image, size);
+	test_write_image(copy, size, 1);
+	test_check("load with recomputed checksum", ini_load_snapshot(TEST_FILENAME, &data));
+	ini_free_data(&data, 0);
+
+	// Every empty slot refers to the first entry, probing of missing key would never end
+	struct ini_slot *slots = (struct ini_slot *)(copy + header.slots);
+	struct ini_slot used = { 0, 0 };
+
+	for (unsigned long long i = 0; i < header.slot_count && !used.index; ++i)
+		used = slots[i];
+
+	for (unsigned long long i = 0; i < header.slot_count; ++i)
+	{
+		if (!slots[i].index)
+			slots[i] = used;
+	}
+
+	test_write_image(copy, size, 1);
+	test_rejected("full index");
+
+	// The same for index of sections
+	memcpy(copy, image, size);
+	slots = (struct ini_slot *)(copy + header.section_slots);
+	used.index = 0;
+
+	for (unsigned long long i = 0; i < header.section_slot_count && !used.index; ++i)
+		used = slots[i];
+
+	for (unsigned long long i = 0; i < header.section_slot_count; ++i)
+	{
+		if (!slots[i].index)
+			slots[i] = used;
+	}
+
+	test_write_image(copy, size, 1);
+	test_rejected("full index of sections");
+
+	// Truncated inside of strings and inside of header
+	test_write_image(image, size - 8, 0);
+	test_rejected("truncated");
+
+	test_write_image(image, sizeof(header) / 2, 0);
+	test_rejected("truncated header");
+
+	// Other version
+	memcpy(copy, image, size);
+	((ini_snapshot_header_t *)copy)->version = INI_SNAPSHOT_VERSION + 1;
+	test_write_image(copy, size, 1);
+	test_rejected("bad version");
+
+	free(copy);
+	free(image);
+}
+
+int main()
+{
+	struct ini_data data;
+	char line[64];
+
+	char *text = malloc(TEST_SECTIONS * (TEST_KEYS + 1) * sizeof(line));
+	size_t length = 0;
+
+	for (int i = 0; i < TEST_SECTIONS; ++i)
+	{
+		length += (size_t)sprintf(text + length, "[section%d]\n", i);
+
+		for (int j = 0; j < TEST_KEYS; ++j)
+			length += (size_t)sprintf(text + length, "key%d = value %d %d\n", j, i, j);
+	}
+
+	if (!ini_parse_buffer_data(text, length, &data))
+	{
+		fprintf(stderr, "Failed to parse table: %s\n", ini_get_last_error_msg());
+		return 2;
+	}
+
+	test_round_trip(&data);
+	test_damaged();
+
+	ini_free_data(&data, 0);
+	free(text);
+
+	remove(TEST_FILENAME);
+
+	printf("%zu checks, %zu failed\n", s_checked, s_failed);
+
+	return s_failed ? 1 : 0;
+}
@@ -0,0 +1,305 @@
+/** Test of writing and patching of files
+*
+*	Copyright (c) 2021 Sw1ft
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+// Files written by ini_write_data and patched by ini_patch_file are compared
+// with expected text. Failed writes (beyond limit of size of files) must leave
+// existing file as it was, links must be written through and keep the file
+// they point to with its mode
+
+// POSIX functions (symlink, lstat) are hidden by strict ISO C modes of glibc
+#if !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+#include "ini_parser.h"
+
+#define TEST_FILENAME "ini_test_write.tmp"
+#define TEST_MISSING_FILENAME "ini_test_write_missing.tmp"
+#define TEST_LINK_FILENAME "ini_test_write_link.tmp"
+
+// Limit of size of files while writes must fail and count of parameters above it
+#define TEST_SIZE_LIMIT 4096
+#define TEST_LARGE_COUNT 2000
+
+static size_t s_checked = 0;
+static size_t s_failed = 0;
+
+//-----------------------------------------------------------------------------
+// Purpose: count check, print failed one
+//-----------------------------------------------------------------------------
+
+static void test_check(const char *name, int success)
+{
+	++s_checked;
+
+	if (!success)
+	{
+		++s_failed;
+		printf("%s: failed (error '%s')\n", name, ini_get_last_error_msg());
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: write text to file
+//-----------------------------------------------------------------------------
+
+static void test_write_text(const char *filename, const char *text)
+{
+	FILE *file = fopen(filename, "wb");
+
+	if (!file || fwrite(text, 1, strlen(text), file) != strlen(text) || fclose(file) != 0)
+	{
+		fprintf(stderr, "Failed to write '%s'\n", filename);
+		exit(2);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: check whether file exists
+//-----------------------------------------------------------------------------
+
+static int test_exists(const char *filename)
+{
+	FILE *file = fopen(filename, "rb");
+
+	if (file)
+		fclose(file);
+
+	return file != NULL;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: check that file contains exactly the expected text
+//-----------------------------------------------------------------------------
+
+static void test_file(const char *name, const char *filename, const char *expected)
+{
+	char buffer[1024];
+	size_t length = 0;
+
+	FILE *file = fopen(filename, "rb");
+
+	if (file)
+	{
+		length = fread(buffer, 1, sizeof(buffer) - 1, file);
+		fclose(file);
+	}
+
+	buffer[length] = '\0';
+
+	test_check(name, file && !strcmp(buffer, expected));
+
+	if (file && strcmp(buffer, expected))
+		printf("expected:\n%s\ngot:\n%s\n", expected, buffer);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: parse hash table of new values from text
+//-----------------------------------------------------------------------------
+
+static void test_values(const char *text, struct ini_data *data)
+{
+	if (!ini_parse_buffer_data(text, strlen(text), data))
+	{
+		fprintf(stderr, "Failed to parse values: %s\n", ini_get_last_error_msg());
+		exit(2);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: written table is read back the same, values may start with '['
+//-----------------------------------------------------------------------------
+
+static void test_write()
+{
+	struct ini_data data;
+	char value[16];
+
+	test_values("[s]\nx = 1\ny = [1,2]\n[t]\nz = [\n", &data);
+	test_check("write", ini_write_data(&data, TEST_FILENAME));
+	test_file("write", TEST_FILENAME, "[s]\nx = 1\ny = [1,2]\n\n[t]\nz = [\n");
+	ini_free_data(&data, 0);
+
+	test_check("read written", ini_parse_data(TEST_FILENAME, &data));
+	test_check("read value starting with '['", ini_copy_data(&data, "s", "y", value, sizeof(value), NULL) && !strcmp(value, "[1,2]"));
+	ini_free_data(&data, 0);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: patched file keeps comments and order, missing parameters are
+// inserted in their sections and missing sections are appended
+//-----------------------------------------------------------------------------
+
+static void test_patch()
+{
+	struct ini_data data;
+
+	// Replaced values keep comments after them
+	test_write_text(TEST_FILENAME, "; header\n[s]\nx = 1 ; old value\ny = 2\n\n[t]\nw = 1\n");
+	test_values("[s]\nx = 5\ny = [1,2]\n", &data);
+	test_check("patch values", ini_patch_file(TEST_FILENAME, &data));
+	test_file("patch values", TEST_FILENAME, "; header\n[s]\nx = 5 ; old value\ny = [1,2]\n\n[t]\nw = 1\n");
+	ini_free_data(&data, 0);
+
+	// Missing key is inserted after the last parameter of its section
+	test_values("[s]\nn = 7\n[t]\nw = 1\n", &data);
+	test_check("patch missing key", ini_patch_file(TEST_FILENAME, &data));
+	test_file("patch missing key", TEST_FILENAME, "; header\n[s]\nx = 5 ; old value\ny = [1,2]\nn = 7\n\n[t]\nw = 1\n");
+	ini_free_data(&data, 0);
+
+	// Missing section is appended to file without final newline
+	test_write_text(TEST_FILENAME, "[s]\nx = 1");
+	test_values("[s]\nx = 1\n[u]\nv = [9]\n", &data);
+	test_check("patch missing section", ini_patch_file(TEST_FILENAME, &data));
+	test_file("patch missing section", TEST_FILENAME, "[s]\nx = 1\n\n[u]\nv = [9]\n");
+	ini_free_data(&data, 0);
+
+	// Missing key of the last section without final newline
+	test_write_text(TEST_FILENAME, "[s]\nx = 1");
+	test_values("[s]\ny = 2\n", &data);
+	test_check("patch key without newline", ini_patch_file(TEST_FILENAME, &data));
+	test_file("patch key without newline", TEST_FILENAME, "[s]\nx = 1\ny = 2\n");
+	ini_free_data(&data, 0);
+}
+
+#ifndef _WIN32
+//-----------------------------------------------------------------------------
+// Purpose: failed write leaves existing file as it was and creates nothing,
+// writes fail by limit of size of files
+//-----------------------------------------------------------------------------
+
+static void test_failure()
+{
+	const char *original = "[s]\nx = 1\n";
+	struct ini_data data;
+	struct rlimit limit;
+
+	// Values are much larger than the limit
+	char *text = malloc(TEST_LARGE_COUNT * 32 + 16);
+	size_t length = (size_t)sprintf(text, "[s]\n");
+
+	for (int i = 0; i < TEST_LARGE_COUNT; ++i)
+		length += (size_t)sprintf(text + length, "key%d = value%d\n", i, i);
+
+	test_values(text, &data);
+	free(text);
+
+	test_write_text(TEST_FILENAME, original);
+	remove(TEST_MISSING_FILENAME);
+
+	if (getrlimit(RLIMIT_FSIZE, &limit) != 0)
+	{
+		printf("failure: skipped\n");
+		ini_free_data(&data, 0);
+		return;
+	}
+
+	struct rlimit small = limit;
+	small.rlim_cur = TEST_SIZE_LIMIT;
+
+	// Write beyond the limit fails with EFBIG instead of the signal
+	signal(SIGXFSZ, SIG_IGN);
+	setrlimit(RLIMIT_FSIZE, &small);
+
+	int written = ini_write_data(&data, TEST_FILENAME);
+	int writtenMissing = ini_write_data(&data, TEST_MISSING_FILENAME);
+	int patched = ini_patch_file(TEST_FILENAME, &data);
+
+	setrlimit(RLIMIT_FSIZE, &limit);
+	signal(SIGXFSZ, SIG_DFL);
+
+	test_check("failed write", !written);
+	test_file("failed write", TEST_FILENAME, original);
+
+	test_check("failed write of new file", !writtenMissing);
+	test_check("failed write of new file creates nothing", !test_exists(TEST_MISSING_FILENAME));
+
+	test_check("failed patch", !patched);
+	test_file("failed patch", TEST_FILENAME, original);
+
+	ini_free_data(&data, 0);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: file pointed by link is replaced and keeps its mode
+//-----------------------------------------------------------------------------
+
+static void test_link()
+{
+	struct ini_data data;
+	struct stat st;
+
+	test_write_text(TEST_FILENAME, "[s]\nx = 1\n");
+	chmod(TEST_FILENAME, 0640);
+
+	remove(TEST_LINK_FILENAME);
+
+	if (symlink(TEST_FILENAME, TEST_LINK_FILENAME) != 0)
+	{
+		printf("link: skipped\n");
+		return;
+	}
+
+	test_values("[s]\nx = 2\n", &data);
+
+	test_check("patch link", ini_patch_file(TEST_LINK_FILENAME, &data));
+	test_check("patch link keeps link", lstat(TEST_LINK_FILENAME, &st) == 0 && S_ISLNK(st.st_mode));
+	test_check("patch link keeps mode", stat(TEST_FILENAME, &st) == 0 && (st.st_mode & 0777) == 0640);
+	test_file("patch link", TEST_FILENAME, "[s]\nx = 2\n");
+
+	test_check("write link", ini_write_data(&data, TEST_LINK_FILENAME));
+	test_check("write link keeps link", lstat(TEST_LINK_FILENAME, &st) == 0 && S_ISLNK(st.st_mode));
+	test_check("write link keeps mode", stat(TEST_FILENAME, &st) == 0 && (st.st_mode & 0777) == 0640);
+
+	ini_free_data(&data, 0);
+	remove(TEST_LINK_FILENAME);
+}
+#endif
+
+int main()
+{
+	test_write();
+	test_patch();
+
+#ifndef _WIN32
+	test_failure();
+	test_link();
+#endif
+
+	remove(TEST_FILENAME);
+
+	printf("%zu checks, %zu failed\n", s_checked, s_failed);
+
+	return s_failed ? 1 : 0;
+}